@@ -24,7 +24,7 @@ void insertion_sort(std::vector<T> & list) {
         int i = j - 1;
 
         // If 'key' is less than current element, decrement
-        while (i > 0 && list[i] > key) {
+        while (i >= 0 && list[i] > key) {
 
             // Copy larger number to higher position
             list[i + 1] = list[i];
@@ -0,0 +1,1204 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Benchmark Harness
+//  Times every algorithm in the repository across input sizes and
+//  distributions, reporting ns/element, throughput and variance
+//
+//  Build:  g++ -std=c++17 -O2 -pthread -o benchmark benchmark.cxx
+//  Usage:  ./benchmark [--min N] [--max N] [--reps R] [--only name]
+//                      [--label version] [--json path|-] [--count]
+//                      [--perf]
+//
+//  --count adds comparison, swap, move and allocation counts for the
+//  instrumented algorithms; --perf also samples hardware counters
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../Instrumentation/instrumentation.h"
+#include "../Instrumentation/thread_count.h"
+
+
+// Every algorithm lives in its own demonstration file with its own main().
+// Include each file into a private namespace and rename its main(), so
+// the demonstrations do not collide with each other or with the harness
+// The renamed demonstrations are never called, so their missing return
+// statements are harmless
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+
+namespace insertion {
+#define main demo
+#include "../Basic Algorithms/insertion_sort.cxx"
+#undef main
+}
+
+namespace merging {
+#define main demo
+#include "../Divide and Conquer/merge_sort.cxx"
+#undef main
+}
+
+namespace quick {
+#define main demo
+#include "../Sorting/quicksort.cxx"
+#undef main
+}
+
+namespace heapsort {
+#define main demo
+#include "../Sorting/max_heapsort.cxx"
+#undef main
+}
+
+namespace queues {
+#define main demo
+#include "../Data Structures/max_priority_queue.cxx"
+#undef main
+}
+
+namespace monotone {
+#define main demo
+#include "../Data Structures/radix_heap.cxx"
+#undef main
+}
+
+namespace indirect {
+#define main demo
+#include "../Sorting/indirect_sort.cxx"
+#undef main
+}
+
+namespace counting {
+#define main demo
+#include "../Sorting/counting_sort.cxx"
+#undef main
+}
+
+namespace bucket {
+#define main demo
+#include "../Sorting/bucket_sort.cxx"
+#undef main
+}
+
+namespace segmented {
+#define main demo
+#include "../Sorting/segmented_sort.cxx"
+#undef main
+}
+
+namespace dispatch {
+#define main demo
+#include "../Sorting/sort.cxx"
+#undef main
+}
+
+namespace subarray {
+#define main demo
+#include "../Divide and Conquer/maximum_subarray.cxx"
+#undef main
+}
+
+namespace multiply {
+#define main demo
+#include "../Divide and Conquer/square_matrix_multiply.cxx"
+#undef main
+}
+
+namespace batched {
+#define main demo
+#include "../Divide and Conquer/batched_matrix_multiply.cxx"
+#undef main
+}
+
+namespace sparse {
+#define main demo
+#include "../Divide and Conquer/sparse_matrix_multiply.cxx"
+#undef main
+}
+
+namespace multiply_recursive {
+#define main demo
+#include "../Divide and Conquer/square_matrix_multiply_recursive.cxx"
+#undef main
+}
+
+#pragma GCC diagnostic pop
+
+
+using bench_clock = std::chrono::steady_clock;
+
+
+// Input distributions. All generators produce integer keys in [0, n), so
+// that every algorithm (including counting sort) accepts the same input
+
+enum class distribution { random, sorted, reversed, few_unique, organ_pipe, zipf, nearly_sorted };
+
+const std::vector<std::pair<distribution, std::string>> distributions{
+    {distribution::random, "random"},
+    {distribution::sorted, "sorted"},
+    {distribution::reversed, "reversed"},
+    {distribution::few_unique, "few_unique"},
+    {distribution::organ_pipe, "organ_pipe"},
+    {distribution::zipf, "zipf"},
+    {distribution::nearly_sorted, "nearly_sorted"}};
+
+
+// Zipf sampling (exponent 1) by binary search over the cumulative weights
+// The number of distinct ranks is capped, so large n remains cheap to build
+std::vector<int> zipf_keys(std::size_t n, std::mt19937_64 & rng) {
+
+    std::size_t ranks = std::min<std::size_t>(n, 1 << 16);
+    std::vector<double> cdf(ranks);
+
+    double total = 0;
+    for (std::size_t k = 0; k < ranks; ++k) {
+        total += 1.0 / (k + 1);
+        cdf[k] = total;
+    }
+
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<int> keys(n);
+
+    for (auto & key: keys)
+        key = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+
+    return keys;
+}
+
+
+std::vector<int> generate_input(distribution d, std::size_t n, std::mt19937_64 & rng) {
+
+    std::vector<int> keys(n);
+
+    switch (d) {
+        case distribution::random: {
+            std::uniform_int_distribution<int> uniform(0, n - 1);
+            for (auto & key: keys)
+                key = uniform(rng);
+            break;
+        }
+        case distribution::sorted:
+            for (std::size_t i = 0; i < n; ++i)
+                keys[i] = i;
+            break;
+        case distribution::reversed:
+            for (std::size_t i = 0; i < n; ++i)
+                keys[i] = n - 1 - i;
+            break;
+        case distribution::few_unique: {
+            std::uniform_int_distribution<int> uniform(0, std::min<std::size_t>(n, 16) - 1);
+            for (auto & key: keys)
+                key = uniform(rng);
+            break;
+        }
+        case distribution::organ_pipe:
+            // Ascending first half, descending second half
+            for (std::size_t i = 0; i < n; ++i)
+                keys[i] = i < n / 2 ? i : n - 1 - i;
+            break;
+        case distribution::zipf:
+            keys = zipf_keys(n, rng);
+            break;
+        case distribution::nearly_sorted: {
+            // Sorted, apart from one shuffled burst of 32 per 1000 keys
+            for (std::size_t i = 0; i < n; ++i)
+                keys[i] = i;
+            const std::size_t burst = 32;
+            if (n > burst) {
+                std::uniform_int_distribution<std::size_t> start(0, n - burst);
+                for (std::size_t b = 0; b < n / 1000; ++b) {
+                    auto first = keys.begin() + start(rng);
+                    std::shuffle(first, first + burst, rng);
+                }
+            }
+            break;
+        }
+    }
+
+    return keys;
+}
+
+
+
+// One timed sample: the mean time of a single run over a batch of runs,
+// the number of elements each run processed, and whether output was valid
+struct measurement {
+    double ns_per_run;
+    std::size_t elements;
+    bool verified;
+};
+
+// Time 'sort' over 'batch' private copies of 'input'. The copies are made
+// before starting the clock, so only the algorithm itself is measured
+template <typename Input, typename Sort, typename Check>
+measurement time_batch(Input const & input, std::size_t elements, int batch,
+        Sort sort, Check check) {
+
+    std::vector<Input> copies(batch, input);
+
+    auto start = bench_clock::now();
+    for (auto & copy: copies)
+        sort(copy);
+    auto stop = bench_clock::now();
+
+    bool verified = std::all_of(copies.begin(), copies.end(), check);
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+    return {ns / batch, elements, verified};
+}
+
+template <typename T>
+bool is_sorted(std::vector<T> const & list) {
+    return std::is_sorted(list.begin(), list.end());
+}
+
+template <typename Sort>
+measurement time_int_sort(std::vector<int> const & input, int batch, Sort sort) {
+    return time_batch(input, input.size(), batch, sort, is_sorted<int>);
+}
+
+
+// Matrix benchmarks treat 'n' as the element count of a square matrix
+// The dimension is rounded down to a power of 2 for the recursive version
+std::size_t matrix_dimension(std::size_t n) {
+
+    std::size_t dimension = 1;
+    while ((2 * dimension) * (2 * dimension) <= n)
+        dimension *= 2;
+    return dimension;
+}
+
+template <typename T>
+std::vector<std::vector<T>> make_matrix(std::vector<int> const & input, std::size_t dimension) {
+
+    std::vector<std::vector<T>> m(dimension, std::vector<T>(dimension));
+    for (std::size_t i = 0; i < dimension; ++i)
+        for (std::size_t j = 0; j < dimension; ++j)
+            m[i][j] = input[i * dimension + j] % 100;
+    return m;
+}
+
+// Reference product used to verify both matrix multiplication algorithms
+template <typename T>
+std::vector<std::vector<T>> reference_product(std::vector<std::vector<T>> const & a,
+        std::vector<std::vector<T>> const & b) {
+
+    std::size_t n = a.size();
+    std::vector<std::vector<T>> c(n, std::vector<T>(n, 0));
+
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t k = 0; k < n; ++k)
+            for (std::size_t j = 0; j < n; ++j)
+                c[i][j] += a[i][k] * b[k][j];
+    return c;
+}
+
+// Check c == a * b. Large products are checked on a random sample of
+// entries, since a full check costs as much as the multiply itself
+template <typename T>
+bool matches_product(std::vector<std::vector<T>> const & a, std::vector<std::vector<T>> const & b,
+        std::vector<std::vector<T>> const & c) {
+
+    std::size_t n = a.size();
+    if (n <= 256)
+        return c == reference_product(a, b);
+
+    std::mt19937_64 rng{n};
+    for (int sample = 0; sample < 1024; ++sample) {
+        std::size_t i = rng() % n, j = rng() % n;
+
+        T sum = 0;
+        for (std::size_t k = 0; k < n; ++k)
+            sum += a[i][k] * b[k][j];
+        if (c[i][j] != sum)
+            return false;
+    }
+    return true;
+}
+
+template <typename Multiply>
+measurement time_matrix_multiply(std::vector<int> const & input, int batch, Multiply multiply) {
+
+    auto dimension = matrix_dimension(input.size());
+    auto a = make_matrix<long long>(input, dimension);
+    auto b = a;
+    std::reverse(b.begin(), b.end());
+
+    std::vector<std::vector<long long>> c;
+
+    auto start = bench_clock::now();
+    for (int run = 0; run < batch; ++run)
+        c = multiply(a, b);
+    auto stop = bench_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns / batch, dimension * dimension, matches_product(a, b, c)};
+}
+
+
+// Kadane's algorithm, used to verify the divide and conquer result
+long long kadane(std::vector<int> const & array) {
+
+    long long best = array[0], current = 0;
+    for (auto value: array) {
+        current = std::max<long long>(value, current + value);
+        best = std::max(best, current);
+    }
+    return best;
+}
+
+
+
+// Shortest path benchmarks run on a random graph with one edge per input
+// key (about 4 edges per vertex), weighted 1 to 100 by the key itself
+using weighted_graph = std::vector<std::vector<std::pair<int, unsigned>>>;
+
+weighted_graph make_graph(std::vector<int> const & input) {
+
+    std::size_t vertices = std::max<std::size_t>(2, input.size() / 4);
+    weighted_graph graph(vertices);
+
+    std::mt19937_64 rng{input.size()};
+    for (auto key: input)
+        graph[rng() % vertices].push_back({int(rng() % vertices), unsigned(key % 100 + 1)});
+    return graph;
+}
+
+// Reference distances from vertex 0, using std::priority_queue
+std::vector<std::uint64_t> reference_distances(weighted_graph const & graph) {
+
+    std::vector<std::uint64_t> distance(graph.size(), std::numeric_limits<std::uint64_t>::max());
+    std::priority_queue<std::pair<std::uint64_t, int>, std::vector<std::pair<std::uint64_t, int>>,
+        std::greater<std::pair<std::uint64_t, int>>> queue;
+
+    distance[0] = 0;
+    queue.push({0, 0});
+    while (!queue.empty()) {
+        auto top = queue.top();
+        queue.pop();
+        if (top.first != distance[top.second])
+            continue;
+        for (auto & edge: graph[top.second])
+            if (top.first + edge.second < distance[edge.first]) {
+                distance[edge.first] = top.first + edge.second;
+                queue.push({distance[edge.first], edge.first});
+            }
+    }
+    return distance;
+}
+
+// Time 'shortest_paths(graph)' on the graph for 'input'; one element per edge
+template <typename ShortestPaths>
+measurement time_shortest_paths(std::vector<int> const & input, int batch,
+        ShortestPaths shortest_paths) {
+
+    auto graph = make_graph(input);
+    auto expected = reference_distances(graph);
+
+    std::vector<std::uint64_t> distance;
+
+    auto start = bench_clock::now();
+    for (int run = 0; run < batch; ++run)
+        distance = shortest_paths(graph);
+    auto stop = bench_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    return {ns / batch, input.size(), distance == expected};
+}
+
+
+// Operation counts (and optionally hardware counters) from one run of an
+// instrumented algorithm
+struct operation_report {
+    operation_counts counts;
+    hardware_sample hardware;
+    bool sampled;
+};
+
+// Run 'sort' once on a copy of 'input' under an instrumentation policy
+// 'sort' is called with a policy object, which only selects its type
+template <typename Sort>
+operation_report count_operations_of(std::vector<int> const & input, bool hardware, Sort sort) {
+
+    auto list = input;
+    operation_report report{};
+
+    if (hardware) {
+        sample_hardware::reset();
+        sort(sample_hardware{}, list);
+        report.counts = sample_hardware::counts();
+        report.sampled = sample_hardware::counters().available();
+
+        for (auto & entry: sample_hardware::samples()) {
+            report.hardware.calls += entry.second.calls;
+            report.hardware.cycles += entry.second.cycles;
+            report.hardware.branch_misses += entry.second.branch_misses;
+            report.hardware.cache_misses += entry.second.cache_misses;
+        }
+    } else {
+        count_operations::reset();
+        sort(count_operations{}, list);
+        report.counts = count_operations::counts();
+    }
+
+    return report;
+}
+
+
+// A benchmarked algorithm: its name, the largest input it will be run on
+// for a given distribution (quadratic cases are capped), a runner, and
+// for instrumented algorithms, an operation counter. Square matrix
+// benchmarks step through power of 2 dimensions rather than powers of 10
+struct algorithm {
+    std::string name;
+    std::function<std::size_t(distribution)> limit;
+    std::function<measurement(std::vector<int> const &, int)> run;
+    std::function<operation_report(std::vector<int> const &, bool)> count;
+    bool square = false;
+};
+
+const std::size_t unlimited = SIZE_MAX;
+
+std::vector<algorithm> make_algorithms() {
+
+    std::vector<algorithm> algorithms;
+
+    algorithms.push_back({"insertion_sort",
+        [](distribution d) {
+            return d == distribution::sorted || d == distribution::nearly_sorted ? unlimited : 100000;
+        },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                insertion::insertion_sort(list);
+            });
+        }});
+
+    algorithms.push_back({"merge_sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                merging::merge_sort(list, 0, list.size() - 1);
+            });
+        },
+        [](std::vector<int> const & input, bool hardware) {
+            return count_operations_of(input, hardware, [](auto policy, std::vector<int> & list) {
+                merging::merge_sort<decltype(policy)>(list, 0, list.size() - 1);
+            });
+        }});
+
+    // Run detection and galloping: close to O(n) on sorted, reversed,
+    // organ_pipe and nearly_sorted input
+    algorithms.push_back({"adaptive_merge_sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                merging::adaptive_merge_sort(list, 0, list.size() - 1);
+            });
+        },
+        [](std::vector<int> const & input, bool hardware) {
+            return count_operations_of(input, hardware, [](auto policy, std::vector<int> & list) {
+                merging::adaptive_merge_sort<decltype(policy)>(list, 0, list.size() - 1);
+            });
+        }});
+
+    // O(sqrt(n)) extra space, against merge_sort's O(n)
+    algorithms.push_back({"merge_sort_in_place",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                merging::merge_sort_in_place(list, 0, list.size() - 1);
+            });
+        },
+        [](std::vector<int> const & input, bool hardware) {
+            return count_operations_of(input, hardware, [](auto policy, std::vector<int> & list) {
+                merging::merge_sort_in_place<decltype(policy)>(list, 0, list.size() - 1);
+            });
+        }});
+
+    // The last element is the pivot, so anything but random input
+    // degenerates to O(n^2) time and O(n) recursion depth
+    algorithms.push_back({"quicksort",
+        [](distribution d) { return d == distribution::random ? unlimited : 10000; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                quick::quicksort(list, 0, list.size() - 1);
+            });
+        },
+        [](std::vector<int> const & input, bool hardware) {
+            return count_operations_of(input, hardware, [](auto policy, std::vector<int> & list) {
+                quick::quicksort<decltype(policy)>(list, 0, list.size() - 1);
+            });
+        }});
+
+    // Selection of the median, checked against std::nth_element
+    algorithms.push_back({"introselect",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            int k = input.size() / 2;
+            auto expected = input;
+            std::nth_element(expected.begin(), expected.begin() + k, expected.end());
+
+            return time_batch(input, input.size(), batch,
+                [k](std::vector<int> & list) { quick::introselect(list, 0, list.size() - 1, k); },
+                [k, &expected](std::vector<int> const & list) { return list[k] == expected[k]; });
+        }});
+
+    // p50, p90 and p99 in one pass
+    algorithms.push_back({"multi_select",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::vector<int> ranks;
+            for (double p: {0.50, 0.90, 0.99})
+                ranks.push_back(p * (input.size() - 1));
+
+            auto expected = input;
+            std::sort(expected.begin(), expected.end());
+
+            return time_batch(input, input.size(), batch,
+                [&ranks](std::vector<int> & list) { quick::multi_select(list, ranks); },
+                [&ranks, &expected](std::vector<int> const & list) {
+                    return std::all_of(ranks.begin(), ranks.end(),
+                        [&](int k) { return list[k] == expected[k]; });
+                });
+        }});
+
+    algorithms.push_back({"max_heapsort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            auto list = input;
+            heapsort::Heap<int> heap{list};
+
+            return time_batch(heap, input.size(), batch,
+                [](heapsort::Heap<int> & heap) { heapsort::max_heapsort(heap); },
+                [](heapsort::Heap<int> const & heap) {
+                    for (std::size_t i = 1; i < heap.length; ++i)
+                        if (heap[i] < heap[i - 1])
+                            return false;
+                    return true;
+                });
+        },
+        [](std::vector<int> const & input, bool hardware) {
+            return count_operations_of(input, hardware, [](auto policy, std::vector<int> & list) {
+                heapsort::Heap<int> heap{list};
+                heapsort::max_heapsort<decltype(policy)>(heap);
+            });
+        }});
+
+    // Merge 64 sorted shards of the input (sorted before timing)
+    algorithms.push_back({"k_way_merge",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::size_t k = std::min<std::size_t>(64, input.size());
+            std::vector<std::vector<int>> shards(k);
+
+            for (std::size_t i = 0; i < input.size(); ++i)
+                shards[i * k / input.size()].push_back(input[i]);
+            for (auto & shard: shards)
+                std::sort(shard.begin(), shard.end());
+
+            using range = std::pair<std::vector<int>::iterator, std::vector<int>::iterator>;
+            std::vector<range> ranges;
+            for (auto & shard: shards)
+                ranges.push_back({shard.begin(), shard.end()});
+
+            std::vector<int> merged(input.size());
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run)
+                queues::k_way_merge(ranges, merged.begin());
+            auto stop = bench_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, input.size(), is_sorted(merged)};
+        }});
+
+    // Keep the 100 largest items of a stream
+    algorithms.push_back({"top_k",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            int k = std::min<std::size_t>(100, input.size());
+
+            auto expected = input;
+            std::sort(expected.rbegin(), expected.rend());
+            expected.resize(k);
+
+            std::vector<int> kept;
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run) {
+                queues::TopK<int> top{k};
+                top.offer(input.begin(), input.end());
+                if (run == 0)
+                    kept = top.sorted();
+            }
+            auto stop = bench_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, input.size(), kept == expected};
+        }});
+
+    // Dijkstra's algorithm with the binary heap of max_priority_queue.cxx
+    // as a min heap. It has no decrease key by vertex, so each improved
+    // distance is inserted again, packed with its vertex into one key, and
+    // stale entries are skipped as they come out
+    algorithms.push_back({"dijkstra_binary_heap",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_shortest_paths(input, batch, [&](weighted_graph const & graph) {
+                std::uint64_t vertices = graph.size();
+                std::vector<std::uint64_t> distance(vertices, std::numeric_limits<std::uint64_t>::max());
+
+                queues::Heap<std::uint64_t, std::less<std::uint64_t>> heap(input.size() + 1);
+                distance[0] = 0;
+                queues::max_heap_insert(heap, std::uint64_t{0});
+
+                while (heap.heap_size > 0) {
+                    auto top = queues::heap_extract_max(heap);
+                    int u = top % vertices;
+                    if (top / vertices != distance[u])
+                        continue;
+                    for (auto & edge: graph[u])
+                        if (distance[u] + edge.second < distance[edge.first]) {
+                            distance[edge.first] = distance[u] + edge.second;
+                            queues::max_heap_insert(heap, distance[edge.first] * vertices + edge.first);
+                        }
+                }
+                return distance;
+            });
+        }});
+
+    algorithms.push_back({"dijkstra_radix_heap",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_shortest_paths(input, batch, [](weighted_graph const & graph) {
+                monotone::RadixHeap<> heap(graph.size());
+                return monotone::dijkstra(graph, 0, heap,
+                    monotone::radix_heap_insert<std::uint64_t>,
+                    monotone::radix_heap_extract_min<std::uint64_t>,
+                    monotone::radix_heap_decrease_key<std::uint64_t>);
+            });
+        }});
+
+    // Edge weights are at most 100, so queued keys stay within 100 of the last
+    algorithms.push_back({"dijkstra_bucket_queue",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_shortest_paths(input, batch, [](weighted_graph const & graph) {
+                monotone::BucketQueue<> queue(graph.size(), 100);
+                return monotone::dijkstra(graph, 0, queue,
+                    monotone::bucket_queue_insert<std::uint64_t>,
+                    monotone::bucket_queue_extract_min<std::uint64_t>,
+                    monotone::bucket_queue_decrease_key<std::uint64_t>);
+            });
+        }});
+
+    // 200 byte records keyed by the input, sorted through a permutation
+    algorithms.push_back({"indirect_sort",
+        [](distribution) { return 1000000; },
+        [](std::vector<int> const & input, int batch) {
+            struct record {
+                int key;
+                char payload[196];
+            };
+
+            std::vector<record> records(input.size());
+            for (std::size_t i = 0; i < input.size(); ++i)
+                records[i].key = input[i];
+
+            return time_batch(records, records.size(), batch,
+                [](std::vector<record> & list) {
+                    indirect::indirect_sort(list, [](record const & r) { return r.key; },
+                        indirect::integer_prefix{});
+                },
+                [](std::vector<record> const & list) {
+                    return std::is_sorted(list.begin(), list.end(),
+                        [](record const & a, record const & b) { return a.key < b.key; });
+                });
+        }});
+
+    algorithms.push_back({"counting_sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, counting::counting_sort);
+        }});
+
+    // Bucket sort expects floats uniformly distributed in [0, 1)
+    algorithms.push_back({"bucket_sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::vector<float> list(input.size());
+            for (std::size_t i = 0; i < input.size(); ++i)
+                list[i] = std::min(input[i] / float(input.size()), std::nextafter(1.0f, 0.0f));
+
+            return time_batch(list, list.size(), batch,
+                [](std::vector<float> & list) { bucket::bucket_sort(list); },
+                is_sorted<float>);
+        }});
+
+    // The input cut into groups of 5 to 500 keys, all sorted in one call
+    algorithms.push_back({"segmented_sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::mt19937_64 rng{input.size()};
+            std::uniform_int_distribution<std::size_t> length(5, 500);
+
+            std::vector<std::size_t> offsets{0};
+            while (offsets.back() < input.size())
+                offsets.push_back(std::min(input.size(), offsets.back() + length(rng)));
+
+            return time_batch(input, input.size(), batch,
+                [&](std::vector<int> & list) { segmented::segmented_sort(list, offsets); },
+                [&](std::vector<int> const & list) {
+                    for (std::size_t s = 0; s + 1 < offsets.size(); ++s)
+                        if (!std::is_sorted(list.begin() + offsets[s], list.begin() + offsets[s + 1]))
+                            return false;
+                    return true;
+                });
+        }});
+
+    // The input aware front end, with its default thresholds
+    algorithms.push_back({"sort",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            return time_int_sort(input, batch, [](std::vector<int> & list) {
+                dispatch::sort(list);
+            });
+        }});
+
+    // Centre keys around zero, so the maximum subarray is non-trivial
+    algorithms.push_back({"maximum_subarray",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::vector<int> array(input.size());
+            for (std::size_t i = 0; i < input.size(); ++i)
+                array[i] = input[i] - int(input.size() / 2);
+
+            auto expected = kadane(array);
+            bool verified = true;
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run) {
+                auto result = subarray::maximum_subarray(array, 0, array.size() - 1);
+                verified = std::get<2>(result) == expected && verified;
+            }
+            auto stop = bench_clock::now();
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, array.size(), verified};
+        }});
+
+    // Row major baseline for the Morton layout below; up to 8192 x 8192
+    algorithms.push_back({"square_matrix_multiply",
+        [](distribution) { return 1 << 26; },
+        [](std::vector<int> const & input, int batch) {
+            return time_matrix_multiply(input, batch,
+                multiply::square_matrix_multiply<long long>);
+        }, nullptr, true});
+
+    // Many independent 4x4 products (n/16 of them), each checked against
+    // the general square_matrix_multiply
+    algorithms.push_back({"fixed_matrix_multiply_4x4",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            using fixed = multiply::FixedMatrix<int, 4>;
+
+            std::vector<fixed> products(std::max<std::size_t>(1, input.size() / 16));
+            for (std::size_t e = 0; e < products.size() * 16; ++e)
+                products[e / 16].elements[e % 16] = input[e % input.size()] % 10;
+
+            fixed b{{1,2,3,4, 0,1,0,1, 2,0,2,0, 1,1,1,1}};
+            auto operands = products;
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run)
+                for (std::size_t m = 0; m < operands.size(); ++m)
+                    products[m] = multiply::square_matrix_multiply(operands[m], b);
+            auto stop = bench_clock::now();
+
+            bool verified = true;
+            for (std::size_t m = 0; m < operands.size(); ++m) {
+                multiply::matrix<int> a_rows(4, std::vector<int>(4)), b_rows = a_rows;
+                for (int i = 0; i < 4; ++i)
+                    for (int j = 0; j < 4; ++j) {
+                        a_rows[i][j] = operands[m](i, j);
+                        b_rows[i][j] = b(i, j);
+                    }
+
+                auto expected = multiply::square_matrix_multiply(a_rows, b_rows);
+                for (int i = 0; i < 4; ++i)
+                    for (int j = 0; j < 4; ++j)
+                        verified = verified && products[m](i, j) == expected[i][j];
+            }
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, operands.size() * 16, verified};
+        }});
+
+    // The same 4x4 products as above, as one batch in interleaved layout
+    algorithms.push_back({"batched_matrix_multiply_4x4",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::size_t count = std::max<std::size_t>(1, input.size() / 16);
+            batched::MatrixBatch<float, 4> a{count}, b{count}, c{count};
+
+            for (std::size_t e = 0; e < count * 16; ++e) {
+                a(e / 16, e % 16 / 4, e % 4) = input[e % input.size()] % 10;
+                b(e / 16, e % 16 / 4, e % 4) = (e % 16) % 3;
+            }
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run)
+                batched::batched_matrix_multiply(a, b, c);
+            auto stop = bench_clock::now();
+
+            // Small integer operands, so the float products are exact
+            bool verified = true;
+            for (std::size_t m = 0; m < count; ++m)
+                verified = verified && c.get(m) == reference_product(a.get(m), b.get(m));
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, count * 16, verified};
+        }});
+
+    // Sparse x sparse product of a matrix with about 1% nonzeros and its
+    // reverse, checked against the sparse x dense product
+    algorithms.push_back({"sparse_matrix_multiply",
+        [](distribution) { return unlimited; },
+        [](std::vector<int> const & input, int batch) {
+            std::size_t dimension = std::sqrt(double(input.size()));
+            std::mt19937_64 rng{7};
+            std::bernoulli_distribution nonzero(0.01);
+
+            sparse::matrix<long long> dense(dimension, std::vector<long long>(dimension, 0));
+            for (std::size_t e = 0; e < dimension * dimension; ++e)
+                if (nonzero(rng))
+                    dense[e / dimension][e % dimension] = input[e] % 100 + 1;
+
+            auto a = sparse::to_csr(dense);
+            std::reverse(dense.begin(), dense.end());
+            auto b = sparse::to_csr(dense);
+
+            sparse::CsrMatrix<long long> c;
+
+            auto start = bench_clock::now();
+            for (int run = 0; run < batch; ++run)
+                c = sparse::sparse_matrix_multiply(a, b);
+            auto stop = bench_clock::now();
+
+            bool verified = sparse::to_dense(c) == sparse::sparse_dense_multiply(a, dense);
+
+            double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+            return measurement{ns / batch, dimension * dimension, verified};
+        }});
+
+    // Includes the conversions to and from Morton layout, which are O(n^2)
+    algorithms.push_back({"square_matrix_multiply_morton",
+        [](distribution) { return 1 << 26; },
+        [](std::vector<int> const & input, int batch) {
+            return time_matrix_multiply(input, batch,
+                [](multiply_recursive::matrix<long long> const & a,
+                        multiply_recursive::matrix<long long> const & b) {
+                    return multiply_recursive::square_matrix_multiply_morton(a, b);
+                });
+        }, nullptr, true});
+
+    algorithms.push_back({"square_matrix_multiply_recursive",
+        [](distribution) { return 1 << 14; },
+        [](std::vector<int> const & input, int batch) {
+            return time_matrix_multiply(input, batch,
+                [](multiply_recursive::matrix<long long> const & a,
+                        multiply_recursive::matrix<long long> const & b) {
+                    return multiply_recursive::square_matrix_multiply_recursive(
+                        a, b, 0, 0, 0, 0, a.size());
+                });
+        }, nullptr, true});
+
+    return algorithms;
+}
+
+
+
+// Summary statistics over the repetitions of one configuration
+struct result {
+    std::string algorithm;
+    std::string distribution;
+    std::size_t n;
+    std::size_t elements;
+    int repetitions;
+    int batch;
+    double mean;
+    double min;
+    double variance;
+    bool verified;
+    bool counted;
+    operation_report operations;
+};
+
+result summarize(std::string const & name, std::string const & dist, std::size_t n,
+        int batch, std::vector<measurement> const & samples) {
+
+    result r{name, dist, n, samples.front().elements, int(samples.size()), batch,
+        0, INFINITY, 0, true, false, {}};
+
+    // Statistics are computed on ns/element of each sample
+    std::vector<double> per_element;
+    for (auto & sample: samples) {
+        per_element.push_back(sample.ns_per_run / sample.elements);
+        r.verified = r.verified && sample.verified;
+    }
+
+    for (auto value: per_element) {
+        r.mean += value / per_element.size();
+        r.min = std::min(r.min, value);
+    }
+
+    // Sample variance (Bessel's correction)
+    if (per_element.size() > 1) {
+        for (auto value: per_element)
+            r.variance += (value - r.mean) * (value - r.mean);
+        r.variance /= per_element.size() - 1;
+    }
+
+    return r;
+}
+
+
+void print_table_header() {
+    std::cout << std::left << std::setw(34) << "algorithm" << std::setw(14) << "input"
+        << std::right << std::setw(12) << "n" << std::setw(14) << "ns/elem"
+        << std::setw(12) << "stddev" << std::setw(16) << "elems/sec" << "  ok\n";
+}
+
+void print_table_row(result const & r) {
+    std::cout << std::left << std::setw(34) << r.algorithm << std::setw(14) << r.distribution
+        << std::right << std::setw(12) << r.n << std::fixed << std::setprecision(3)
+        << std::setw(14) << r.mean << std::setw(12) << std::sqrt(r.variance)
+        << std::scientific << std::setprecision(3) << std::setw(16) << 1e9 / r.mean
+        << std::defaultfloat << "  " << (r.verified ? "yes" : "NO") << std::endl;
+
+    if (!r.counted)
+        return;
+
+    // Operation counts are printed per element, below the timing row
+    auto & counts = r.operations.counts;
+    double n = r.elements;
+
+    std::cout << "    " << std::fixed << std::setprecision(2)
+        << "cmp/elem " << counts.comparisons / n
+        << "  swaps/elem " << counts.swaps / n
+        << "  moves/elem " << counts.moves / n
+        << "  allocs " << counts.allocations;
+
+    if (r.operations.sampled) {
+        auto & hardware = r.operations.hardware;
+        std::cout << "  cycles/elem " << hardware.cycles / n
+            << "  br-miss/elem " << hardware.branch_misses / n
+            << "  llc-miss/elem " << hardware.cache_misses / n;
+    }
+
+    std::cout << std::defaultfloat << std::endl;
+}
+
+// A JSON string literal: quotes, backslashes and control characters
+// (such as those in a --label) are escaped
+std::string json_string(std::string const & text) {
+
+    const char * hex = "0123456789abcdef";
+    std::string quoted = "\"";
+
+    for (unsigned char c: text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c < 0x20) {
+            quoted += "\\u00";
+            quoted += hex[c >> 4];
+            quoted += hex[c & 0xf];
+        } else {
+            quoted += c;
+        }
+    }
+
+    return quoted + '"';
+}
+
+void write_json(std::ostream & out, std::string const & label, std::vector<result> const & results) {
+
+    out << "{\n  \"label\": " << json_string(label) << ",\n"
+        << "  \"compiler\": " << json_string(__VERSION__) << ",\n"
+        << "  \"results\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        auto & r = results[i];
+        out << (i ? ",\n" : "\n") << std::setprecision(9)
+            << "    {\"algorithm\": " << json_string(r.algorithm) << ", "
+            << "\"distribution\": " << json_string(r.distribution) << ", "
+            << "\"n\": " << r.n << ", "
+            << "\"elements\": " << r.elements << ", "
+            << "\"repetitions\": " << r.repetitions << ", "
+            << "\"batch\": " << r.batch << ", "
+            << "\"ns_per_element\": " << r.mean << ", "
+            << "\"ns_per_element_min\": " << r.min << ", "
+            << "\"ns_per_element_variance\": " << r.variance << ", "
+            << "\"elements_per_second\": " << 1e9 / r.mean << ", "
+            << "\"verified\": " << (r.verified ? "true" : "false");
+
+        if (r.counted) {
+            auto & counts = r.operations.counts;
+            out << ", \"comparisons\": " << counts.comparisons
+                << ", \"swaps\": " << counts.swaps
+                << ", \"moves\": " << counts.moves
+                << ", \"allocations\": " << counts.allocations
+                << ", \"allocated_bytes\": " << counts.allocated_bytes;
+        }
+
+        if (r.counted && r.operations.sampled) {
+            auto & hardware = r.operations.hardware;
+            out << ", \"cycles\": " << hardware.cycles
+                << ", \"branch_misses\": " << hardware.branch_misses
+                << ", \"cache_misses\": " << hardware.cache_misses;
+        }
+
+        out << "}";
+    }
+
+    out << "\n  ]\n}" << std::endl;
+}
+
+
+// Input sizes from 'min' to 'max': powers of 10, or for square matrix
+// benchmarks d x d elements for each power of 2 dimension d, where 'min'
+// rounds down to a square (--min 1e5 starts at 256 x 256)
+std::vector<std::size_t> input_sizes(std::size_t min_n, std::size_t max_n, bool square) {
+
+    std::vector<std::size_t> sizes;
+
+    if (square) {
+        for (auto d = matrix_dimension(min_n); d * d <= max_n; d *= 2)
+            sizes.push_back(d * d);
+        return sizes;
+    }
+
+    for (std::size_t n = min_n; n <= max_n; n *= 10) {
+        sizes.push_back(n);
+        if (n > max_n / 10)
+            break;
+    }
+    return sizes;
+}
+
+
+// Entry point
+int main(int argc, char * argv[]) {
+
+    // Sizes run in powers of 10 from 'min' to 'max' (see input_sizes). 10^9
+    // is supported but needs several GB of memory, so the default stops at 10^6
+    std::size_t min_n = 10, max_n = 1000000;
+    int repetitions = 5;
+    std::string only, label = "unlabelled", json_path;
+    bool count = false, hardware = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+
+        // Flags without a value
+        if (flag == "--count" || flag == "--perf") {
+            count = true;
+            hardware = hardware || flag == "--perf";
+            continue;
+        }
+
+        if (i + 1 == argc) {
+            std::cerr << "Missing value for " << flag << std::endl;
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (flag == "--min")         min_n = std::stod(value);
+        else if (flag == "--max")    max_n = std::stod(value);
+        else if (flag == "--reps")   repetitions = std::max(1, std::stoi(value));
+        else if (flag == "--only")   only = value;
+        else if (flag == "--label")  label = value;
+        else if (flag == "--json")   json_path = value;
+        else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    std::mt19937_64 rng{42};
+    std::vector<result> results;
+
+    // Keep the human readable table off stdout when JSON is written there
+    bool table = json_path != "-";
+    if (table)
+        print_table_header();
+
+    for (auto & algorithm: make_algorithms()) {
+        if (!only.empty() && algorithm.name != only)
+            continue;
+
+        for (auto & dist: distributions) {
+            for (std::size_t n: input_sizes(min_n, max_n, algorithm.square)) {
+                if (n > algorithm.limit(dist.first))
+                    break;
+
+                auto input = generate_input(dist.first, n, rng);
+
+                // Small inputs finish faster than the clock resolution, so
+                // each sample times a batch of roughly 10^5 elements
+                int batch = std::max<std::size_t>(1, 100000 / n);
+
+                std::vector<measurement> samples;
+                for (int rep = 0; rep < repetitions; ++rep)
+                    samples.push_back(algorithm.run(input, batch));
+
+                results.push_back(summarize(algorithm.name, dist.second, n, batch, samples));
+
+                if (count && algorithm.count) {
+                    results.back().counted = true;
+                    results.back().operations = algorithm.count(input, hardware);
+                }
+
+                if (table)
+                    print_table_row(results.back());
+            }
+        }
+    }
+
+    if (json_path == "-")
+        write_json(std::cout, label, results);
+    else if (!json_path.empty()) {
+        std::ofstream out{json_path};
+        write_json(out, label, results);
+    }
+
+    bool verified = std::all_of(results.begin(), results.end(),
+        [](result const & r) { return r.verified; });
+    return verified ? 0 : 2;
+}
@@ -12,30 +12,43 @@
 #include <vector>
 #include <algorithm>
 #include <climits>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+#include "../Instrumentation/instrumentation.h"
 
 
 // This priority queue implementation stores priority values (keys) only,
 // directly in a max heap. As such, it follows the ordering property defined
 // by a max heap. Therefore, highest priority elements are stored at top
+//
+// 'Compare' decides which of two keys has the higher priority. The
+// default, std::greater, gives the max heap described above; std::less
+// turns every operation below into its min heap counterpart
 
 
 // A custom C++ Heap class
-template <typename T>
+template <typename T, typename Compare = std::greater<T>>
 class Heap {
 
     private:
         // This implementation will represent the heap as an 'array'
         std::vector<T> heap;
+        Compare compare;
 
     public:
         int heap_size;
         long unsigned int length;
 
         // Constructors
-        Heap<T>(int n) : heap{n}, heap_size{0}, length{n} {}
-        Heap<T>(std::vector<T> & list) : heap{list},
+        Heap(int n) : heap(n), heap_size{0}, length(n) {}
+        Heap(std::vector<T> & list) : heap{list},
             heap_size{0}, length{list.size()} {}
 
+        // True if key 'a' has a higher priority than key 'b'
+        bool higher(const T & a, const T & b) const { return compare(a, b); }
+
         // Overridden [] mutator
         T & operator[](int index) {
             if (index < 0)
@@ -62,54 +75,57 @@ class Heap {
 
 // Heapify w/ max heap (pg. 154) - O(log n)
 // If needed, make heap[index] 'float down' to satisfy ordering property
-template <typename T>
-void max_heapify(Heap<T> & heap, int index) {
+// Comparisons and swaps are reported to the 'Instrument' policy
+template <typename Instrument = no_instrumentation, typename T, typename Compare>
+void max_heapify(Heap<T, Compare> & heap, int index) {
+
+    typename Instrument::scope sample{"max_heapify"};
 
     int largest;
 
     int left = heap.left(index);
     int right = heap.right(index);
 
-    if (left < heap.heap_size && heap[left] > heap[index])
+    if (left < heap.heap_size && Instrument::compare(heap.higher(heap[left], heap[index])))
         largest = left;
     else
         largest = index;
 
-    if (right < heap.heap_size && heap[right] > heap[largest])
+    if (right < heap.heap_size && Instrument::compare(heap.higher(heap[right], heap[largest])))
         largest = right;
 
     if (largest != index) {
-        std::swap(heap[index], heap[largest]);
+        Instrument::swap(heap[index], heap[largest]);
 
-        max_heapify(heap, largest);
+        max_heapify<Instrument>(heap, largest);
     }
 }
 
 
 // Build Heap w/ max heap (pg. 157) - O(n)
 // Heapify all non-leaf nodes to make them sink to appropriate spot
-template <typename T>
-void build_max_heap(Heap<T> & heap) {
+template <typename Instrument = no_instrumentation, typename T, typename Compare>
+void build_max_heap(Heap<T, Compare> & heap) {
 
     heap.heap_size = heap.length;
     for (int index = ((heap.length - 1) / 2); index >= 0; --index)
-        max_heapify(heap, index);
+        max_heapify<Instrument>(heap, index);
 }
 
 
 
 // Heap maximum w/ max heap (pg. 163) - O(1)
 // Return the 'maximum' element in the heap
-template <typename T>
-T heap_maximum(Heap<T> & heap) {
+template <typename T, typename Compare>
+T heap_maximum(Heap<T, Compare> & heap) {
     return heap[0];
 }
 
 
 // Priority queue extract maximum w/ max heap (pg. 163) - O(log n)
 // Retrieves and remove maximum element from heap, then reorders heap
-template <typename T>
-T heap_extract_max(Heap<T> & heap) {
+template <typename Instrument = no_instrumentation, typename T, typename Compare>
+T heap_extract_max(Heap<T, Compare> & heap) {
 
     // Error
     if (heap.heap_size < 1) {
@@ -124,8 +140,9 @@ T heap_extract_max(Heap<T> & heap) {
     // heapify it back into proper position based on priority (O(log n))
     heap[0] = heap[heap.heap_size - 1];
     --heap.heap_size;
+    Instrument::move(1);
 
-    max_heapify(heap, 0);
+    max_heapify<Instrument>(heap, 0);
 
     return max;
 }
@@ -133,11 +150,14 @@ T heap_extract_max(Heap<T> & heap) {
 
 // Priority queue increase key w/ max heap (pg. 164) - O(log n)
 // Increases the key (priority) of an element, then reorders heap
-template <typename T>
-void heap_increase_key(Heap<T> & heap, int index, T key) {
+// Comparisons and swaps are reported to the 'Instrument' policy
+template <typename Instrument = no_instrumentation, typename T, typename Compare>
+void heap_increase_key(Heap<T, Compare> & heap, int index, T key) {
+
+    typename Instrument::scope sample{"heap_increase_key"};
 
-    if (key < heap[index]) {
-        std::cout << "\tError: New key is smaller than current key." << std::endl;
+    if (Instrument::compare(heap.higher(heap[index], key))) {
+        std::cout << "\tError: New key has lower priority than current key." << std::endl;
         return;
     }
 
@@ -146,10 +166,10 @@ void heap_increase_key(Heap<T> & heap, int index, T key) {
 
     // To fix the likely violation of heap ordering property, reorder the heap
     // by traversing up the heap, comparing current index element with parent (O(log n))
-    while (index > 0 && heap[heap.parent(index)] < heap[index]) {
+    while (index > 0 && Instrument::compare(heap.higher(heap[index], heap[heap.parent(index)]))) {
 
         // Current index will become parent's to allow comparison with the parent's parent
-        std::swap(heap[index], heap[heap.parent(index)]);
+        Instrument::swap(heap[index], heap[heap.parent(index)]);
         index = heap.parent(index);
     }
 }
@@ -157,18 +177,238 @@ void heap_increase_key(Heap<T> & heap, int index, T key) {
 
 // Priority queue insert w/ max heap (pg. 164) - O(log n)
 // Inserts a new element into priority queue / heap
-template <typename T>
-void max_heap_insert(Heap<T> & heap, T key) {
+template <typename Instrument = no_instrumentation, typename T, typename Compare>
+void max_heap_insert(Heap<T, Compare> & heap, T key) {
 
-    // Clear out a spot at the end for new element (no priority yet)
+    // Clear out a spot at the end for new element. The book gives it the
+    // lowest possible priority; placing 'key' itself there is equivalent
+    // and works for any key type and ordering
     ++heap.heap_size;
-    heap[heap.heap_size - 1] = INT_MIN;
+    heap[heap.heap_size - 1] = key;
 
     // Now that you are providing a priority, sort it into place (O (log n))
-    heap_increase_key(heap, heap.heap_size - 1, key);
+    heap_increase_key<Instrument>(heap, heap.heap_size - 1, key);
+}
+
+
+// K-Way Merge (exercise 6.5-9) - O(n log k)
+// Merge k sorted sequences by keeping only the head of each one in a min
+// heap. The root is the smallest remaining element; once it is written
+// out, it is replaced by the next element from the same source and sifted
+// down (a tournament replay), so no intermediate concatenation is needed
+
+
+// The current head of one source in the merge
+template <typename T>
+struct merge_head {
+    T key;
+    int source;
+};
+
+// Smallest key wins. Equal keys go to the earlier source, so the merge is
+// stable with respect to the order the sources were given in
+struct lowest_head {
+    template <typename T>
+    bool operator()(const merge_head<T> & a, const merge_head<T> & b) const {
+        return a.key < b.key || (!(b.key < a.key) && a.source < b.source);
+    }
+};
+
+
+// Replace the winner at the root with the next key from its source, or
+// drop it once the source is exhausted, then restore the heap property
+template <typename Instrument, typename T, typename Next>
+void replay_winner(Heap<merge_head<T>, lowest_head> & tournament, Next next) {
+
+    auto & winner = tournament[0];
+
+    if (!next(winner.source, winner.key)) {
+        winner = tournament[tournament.heap_size - 1];
+        --tournament.heap_size;
+    }
+
+    max_heapify<Instrument>(tournament, 0);
+}
+
+
+// Merge sorted iterator ranges [first, last) into 'out'. Returns the end
+// of the output, as the standard algorithms do
+template <typename Instrument = no_instrumentation, typename InputIt, typename OutputIt>
+OutputIt k_way_merge(std::vector<std::pair<InputIt, InputIt>> ranges, OutputIt out) {
+
+    using T = typename std::iterator_traits<InputIt>::value_type;
+
+    std::vector<merge_head<T>> heads;
+    for (int source = 0; source < (int)ranges.size(); ++source)
+        if (ranges[source].first != ranges[source].second)
+            heads.push_back({*ranges[source].first++, source});
+
+    if (heads.empty())
+        return out;
+
+    Heap<merge_head<T>, lowest_head> tournament{heads};
+    build_max_heap<Instrument>(tournament);
+
+    auto next = [&ranges](int source, T & key) {
+        auto & range = ranges[source];
+        if (range.first == range.second)
+            return false;
+        key = *range.first++;
+        return true;
+    };
+
+    while (tournament.heap_size > 0) {
+        *out++ = tournament[0].key;
+        replay_winner<Instrument>(tournament, next);
+    }
+
+    return out;
+}
+
+
+// Merge sorted streams that are read lazily, in batches. Each reader is a
+// callable 'std::size_t read(T * buffer, std::size_t capacity)' returning
+// how many elements it wrote, and 0 once its stream is exhausted. Every
+// source owns a slice of one contiguous buffer, refilled 'batch' elements
+// at a time, so the merge walks through memory sequentially. A batch of
+// 0 would read nothing and end every stream at once, so it is taken as 1
+template <typename T, typename Instrument = no_instrumentation, typename Reader, typename OutputIt>
+OutputIt k_way_merge_streams(std::vector<Reader> & readers, OutputIt out,
+        std::size_t batch = 1024) {
+
+    int k = readers.size();
+    batch = std::max<std::size_t>(1, batch);
+
+    std::vector<T> buffers(k * batch);
+    std::vector<std::size_t> position(k, 0), filled(k, 0);
+
+    auto next = [&](int source, T & key) {
+        if (position[source] == filled[source]) {
+            filled[source] = readers[source](buffers.data() + source * batch, batch);
+            position[source] = 0;
+
+            if (filled[source] == 0)
+                return false;
+        }
+        key = buffers[source * batch + position[source]++];
+        return true;
+    };
+
+    std::vector<merge_head<T>> heads;
+    for (int source = 0; source < k; ++source) {
+        T key;
+        if (next(source, key))
+            heads.push_back({key, source});
+    }
+
+    if (heads.empty())
+        return out;
+
+    Heap<merge_head<T>, lowest_head> tournament{heads};
+    build_max_heap<Instrument>(tournament);
+
+    while (tournament.heap_size > 0) {
+        *out++ = tournament[0].key;
+        replay_winner<Instrument>(tournament, next);
+    }
+
+    return out;
 }
 
 
+// Bounded Top-K Selector - O(log k) per accepted item, O(1) per rejection
+// Keeps the k largest items seen in a stream, in a min heap of fixed
+// capacity k. The root is the smallest item kept (the admission
+// threshold), so once the heap is full most items are rejected by a single
+// comparison against it. The heap is allocated once and never grows
+template <typename T>
+class TopK {
+
+    private:
+        Heap<T, std::less<T>> heap;
+
+        // Items are scanned for candidates in blocks of this many
+        static const int block = 64;
+
+    public:
+        TopK(int k) : heap(k) {}
+
+        int size() const { return heap.heap_size; }
+        int capacity() const { return heap.length; }
+        bool full() const { return heap.heap_size == (int)heap.length; }
+
+        // Smallest item kept. Only meaningful when size() > 0
+        const T & threshold() const { return heap[0]; }
+
+        // Offer one item, returning true if it was kept
+        bool offer(const T & item) {
+
+            if (!full()) {
+                max_heap_insert(heap, item);
+                return true;
+            }
+
+            if (capacity() == 0 || !(heap[0] < item))
+                return false;
+
+            // Replace the smallest kept item and let the new one sink
+            heap[0] = item;
+            max_heapify(heap, 0);
+            return true;
+        }
+
+        // Offer a batch of items. Each block is first tested against the
+        // current threshold by counting the items above it, a branch free
+        // integer sum that the compiler vectorizes for arithmetic types, and
+        // only blocks that contain a candidate are offered item by item
+        template <typename RandomIt>
+        void offer(RandomIt first, RandomIt last) {
+
+            while (first != last && !full())
+                offer(*first++);
+
+            if (capacity() == 0)
+                return;
+
+            while (last - first >= block) {
+
+                const T limit = heap[0];
+                int hits = 0;
+
+                for (int i = 0; i < block; ++i)
+                    hits += limit < first[i];
+
+                if (hits > 0)
+                    for (int i = 0; i < block; ++i)
+                        offer(first[i]);
+
+                first += block;
+            }
+
+            while (first != last)
+                offer(*first++);
+        }
+
+        // Fold in another selector, e.g. one filled by another thread
+        void merge(const TopK & other) {
+            for (int i = 0; i < other.heap.heap_size; ++i)
+                offer(other.heap[i]);
+        }
+
+        // The kept items, largest first
+        std::vector<T> sorted() const {
+
+            auto copy = heap;
+            std::vector<T> items(copy.heap_size);
+
+            for (int i = items.size() - 1; i >= 0; --i)
+                items[i] = heap_extract_max(copy);
+
+            return items;
+        }
+};
+
+
 // Demonstration
 int main() {
 
@@ -190,4 +430,29 @@ int main() {
       std::cout << "Next up, extracting element with priority "
         << next << std::endl;
     }
+
+    // Merge several sorted shards with a min heap tournament
+    std::vector<std::vector<int>> shards{{1,5,9}, {2,3,10,11}, {0,4,6}};
+
+    std::vector<std::pair<std::vector<int>::iterator, std::vector<int>::iterator>> ranges;
+    for (auto & shard: shards)
+      ranges.push_back({shard.begin(), shard.end()});
+
+    std::vector<int> merged;
+    k_way_merge(ranges, std::back_inserter(merged));
+
+    std::cout << "\nMerged shards: ";
+    for (auto & key: merged)
+      std::cout << key << ' ';
+    std::cout << std::endl;
+
+    // Keep only the 3 highest scores from a stream
+    std::vector<int> scores{12,87,45,3,99,61,87,20,74,5};
+    TopK<int> leaderboard{3};
+    leaderboard.offer(scores.begin(), scores.end());
+
+    std::cout << "\nTop 3 scores: ";
+    for (auto & score: leaderboard.sorted())
+      std::cout << score << ' ';
+    std::cout << std::endl;
 }
@@ -0,0 +1,345 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Monotone Integer Priority Queues: Radix Heap and Bucket Queue
+//  (Dijkstra's algorithm pg. 658, problem 24-4 and exercise 24.3-8)
+//  Radix heap: O(1) insert and decrease key, O(log C) amortized extract min
+//  Bucket (Dial) queue: O(1) insert and decrease key, O(C) total scanning
+//  C is the largest key, or the largest key span, respectively
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+
+//  The binary heap of max_priority_queue.cxx compares keys, so every
+//  operation costs O(log n). In Dijkstra's algorithm and similar
+//  schedulers two more facts hold: keys are integers, and they are
+//  monotone (no key inserted is ever smaller than the last key extracted).
+//  Both queues below rely on these facts to avoid comparisons altogether.
+//
+//  Both queues hold items 0 .. n - 1 (such as vertices), each with a key.
+//  Their interface follows max_heap_insert, heap_extract_max and
+//  heap_increase_key, as a min priority queue: insert an item, extract the
+//  item with the smallest key, and decrease an item's key. Here an item
+//  is named by its number rather than by its position in the queue.
+
+
+// Items grouped into buckets, where each item knows its bucket and its
+// slot in that bucket, so it can be removed in O(1) from anywhere
+class ItemBuckets {
+
+    public:
+        // bucket_of[item] for an item that is not queued
+        static constexpr std::size_t not_queued = std::size_t(-1);
+
+        std::vector<std::vector<int>> buckets;
+        std::vector<std::size_t> bucket_of;
+        std::vector<int> slot;
+
+        ItemBuckets(int items, std::size_t count) : buckets(count),
+            bucket_of(items, not_queued), slot(items, 0) {}
+
+        void add(int item, std::size_t bucket) {
+            bucket_of[item] = bucket;
+            slot[item] = buckets[bucket].size();
+            buckets[bucket].push_back(item);
+        }
+
+        // Fill the item's slot with the last item of the same bucket
+        void remove(int item) {
+            auto & bucket = buckets[bucket_of[item]];
+            int last = bucket.back();
+            bucket[slot[item]] = last;
+            slot[last] = slot[item];
+            bucket.pop_back();
+            bucket_of[item] = not_queued;
+        }
+
+        bool contains(int item) const { return bucket_of[item] != not_queued; }
+};
+
+
+
+//  Radix Heap
+//  Bucket 0 holds keys equal to 'last', the last key extracted. Bucket i
+//  holds keys whose highest bit that differs from 'last' is bit i - 1,
+//  so bucket i covers keys in [last, last + 2^i), roughly. Extract min
+//  empties bucket 0 first. When it is empty, the first non-empty bucket
+//  holds the minimum: find it, make it the new 'last', and redistribute
+//  that bucket. Each of its keys now agrees with 'last' on one more bit,
+//  so it moves to a strictly lower bucket; a key moves at most once per
+//  bit, hence O(log C) amortized.
+
+template <typename Key = std::uint64_t>
+class RadixHeap {
+
+    static_assert(std::is_unsigned<Key>::value, "RadixHeap needs an unsigned integer key");
+
+    public:
+        static const int bits = std::numeric_limits<Key>::digits;
+
+        ItemBuckets items;
+        std::vector<Key> key;
+        Key last;
+        int heap_size;
+
+        RadixHeap(int n) : items(n, bits + 1), key(n), last{0}, heap_size{0} {}
+
+        // Bucket for 'k' relative to 'last': 0 if equal, else the position
+        // of the highest differing bit, plus one
+        int bucket(Key k) const {
+            Key differ = k ^ last;
+            int b = 0;
+            while (differ) {
+                differ >>= 1;
+                ++b;
+            }
+            return b;
+        }
+};
+
+// Count the bits after the highest set bit, where the compiler allows it
+template <>
+inline int RadixHeap<std::uint64_t>::bucket(std::uint64_t k) const {
+    std::uint64_t differ = k ^ last;
+    return differ == 0 ? 0 : 64 - __builtin_clzll(differ);
+}
+
+
+// Radix heap insert - O(1)
+template <typename Key>
+void radix_heap_insert(RadixHeap<Key> & heap, int item, Key key) {
+
+    if (key < heap.last) {
+        std::cout << "\tError: Key is smaller than the last key extracted." << std::endl;
+        return;
+    }
+
+    heap.key[item] = key;
+    heap.items.add(item, heap.bucket(key));
+    ++heap.heap_size;
+}
+
+
+// Radix heap extract minimum - O(log C) amortized
+// Returns the item with the smallest key (its key is heap.key[item])
+template <typename Key>
+int radix_heap_extract_min(RadixHeap<Key> & heap) {
+
+    if (heap.heap_size < 1) {
+        std::cout << "\tError: Heap underflow" << std::endl;
+        return -1;
+    }
+
+    auto & buckets = heap.items.buckets;
+
+    if (buckets[0].empty()) {
+
+        int b = 1;
+        while (buckets[b].empty())
+            ++b;
+
+        // The smallest key in bucket b becomes 'last'
+        Key minimum = std::numeric_limits<Key>::max();
+        for (int item: buckets[b])
+            minimum = std::min(minimum, heap.key[item]);
+        heap.last = minimum;
+
+        // Every key in bucket b moves to a lower bucket
+        std::vector<int> moving;
+        std::swap(moving, buckets[b]);
+        for (int item: moving)
+            heap.items.add(item, heap.bucket(heap.key[item]));
+
+        // Keep the bucket's memory for later (it was moved out above)
+        moving.clear();
+        std::swap(moving, buckets[b]);
+    }
+
+    int item = buckets[0].back();
+    heap.items.remove(item);
+    --heap.heap_size;
+
+    return item;
+}
+
+
+// Radix heap decrease key - O(1)
+// The new key may not be below the last key extracted
+template <typename Key>
+void radix_heap_decrease_key(RadixHeap<Key> & heap, int item, Key key) {
+
+    if (key > heap.key[item] || key < heap.last) {
+        std::cout << "\tError: New key is larger than current key, "
+            "or smaller than the last key extracted." << std::endl;
+        return;
+    }
+
+    heap.items.remove(item);
+    heap.key[item] = key;
+    heap.items.add(item, heap.bucket(key));
+}
+
+
+
+//  Bucket (Dial) Queue
+//  When every queued key lies within 'span' of the last key extracted
+//  (in Dijkstra's algorithm, span is the largest edge weight), keep one
+//  bucket per key value in a circular array of span + 1 buckets. Extract
+//  min scans forward from the last key to the next non-empty bucket; since
+//  keys are monotone, the scan never moves backwards, so all scanning
+//  together costs O(C) for a largest extracted key C. Best for small spans.
+
+template <typename Key = std::uint64_t>
+class BucketQueue {
+
+    static_assert(std::is_unsigned<Key>::value, "BucketQueue needs an unsigned integer key");
+
+    public:
+        ItemBuckets items;
+        std::vector<Key> key;
+        Key span;
+        Key last;
+        int heap_size;
+
+        BucketQueue(int n, Key span) : items(n, bucket_count(span)), key(n),
+            span{span}, last{0}, heap_size{0} {}
+
+        std::size_t bucket(Key k) const { return k % (span + 1); }
+
+        // One bucket per key in [last, last + span]. A span whose bucket
+        // count does not fit in std::size_t is rejected, not wrapped around
+        static std::size_t bucket_count(Key span) {
+            if (span >= std::numeric_limits<Key>::max() || span >= std::numeric_limits<std::size_t>::max())
+                throw std::length_error("BucketQueue span is too large");
+            return std::size_t(span) + 1;
+        }
+};
+
+
+// Bucket queue insert - O(1)
+template <typename Key>
+void bucket_queue_insert(BucketQueue<Key> & queue, int item, Key key) {
+
+    if (key < queue.last || key - queue.last > queue.span) {
+        std::cout << "\tError: Key is outside [last, last + span]." << std::endl;
+        return;
+    }
+
+    queue.key[item] = key;
+    queue.items.add(item, queue.bucket(key));
+    ++queue.heap_size;
+}
+
+
+// Bucket queue extract minimum - O(1) plus the buckets scanned
+template <typename Key>
+int bucket_queue_extract_min(BucketQueue<Key> & queue) {
+
+    if (queue.heap_size < 1) {
+        std::cout << "\tError: Heap underflow" << std::endl;
+        return -1;
+    }
+
+    auto & buckets = queue.items.buckets;
+    while (buckets[queue.bucket(queue.last)].empty())
+        ++queue.last;
+
+    int item = buckets[queue.bucket(queue.last)].back();
+    queue.items.remove(item);
+    --queue.heap_size;
+
+    return item;
+}
+
+
+// Bucket queue decrease key - O(1)
+template <typename Key>
+void bucket_queue_decrease_key(BucketQueue<Key> & queue, int item, Key key) {
+
+    if (key > queue.key[item] || key < queue.last) {
+        std::cout << "\tError: New key is larger than current key, "
+            "or smaller than the last key extracted." << std::endl;
+        return;
+    }
+
+    queue.items.remove(item);
+    queue.key[item] = key;
+    queue.items.add(item, queue.bucket(key));
+}
+
+
+
+//  Dijkstra's algorithm (pg. 658) over either queue, for a graph given as
+//  adjacency lists of (vertex, weight). Returns the distance to every
+//  vertex, or the largest Key for vertices that cannot be reached.
+//  'insert', 'extract_min' and 'decrease_key' are the queue's operations
+
+template <typename Queue, typename Insert, typename Extract, typename Decrease>
+std::vector<std::uint64_t> dijkstra(std::vector<std::vector<std::pair<int, unsigned>>> const & graph,
+        int source, Queue & queue, Insert insert, Extract extract_min, Decrease decrease_key) {
+
+    const auto infinity = std::numeric_limits<std::uint64_t>::max();
+    std::vector<std::uint64_t> distance(graph.size(), infinity);
+
+    distance[source] = 0;
+    insert(queue, source, std::uint64_t{0});
+
+    while (queue.heap_size > 0) {
+
+        int u = extract_min(queue);
+
+        // Relax every edge leaving u (pg. 649)
+        for (auto & edge: graph[u]) {
+            int v = edge.first;
+            auto through_u = distance[u] + edge.second;
+
+            if (through_u < distance[v]) {
+                if (distance[v] == infinity)
+                    insert(queue, v, through_u);
+                else
+                    decrease_key(queue, v, through_u);
+                distance[v] = through_u;
+            }
+        }
+    }
+
+    return distance;
+}
+
+
+// Demonstration
+int main(int argc, char * argv[]) {
+
+    // The example graph of figure 24.6, vertices s, t, x, y, z as 0 - 4
+    std::vector<std::vector<std::pair<int, unsigned>>> graph{
+        {{1, 10}, {3, 5}},
+        {{2, 1}, {3, 2}},
+        {{4, 4}},
+        {{1, 3}, {2, 9}, {4, 2}},
+        {{0, 7}, {2, 6}}};
+
+    RadixHeap<> radix{5};
+    auto by_radix = dijkstra(graph, 0, radix,
+        radix_heap_insert<std::uint64_t>, radix_heap_extract_min<std::uint64_t>,
+        radix_heap_decrease_key<std::uint64_t>);
+
+    // Keys stay within the largest edge weight (10) of the last key
+    BucketQueue<> buckets{5, 10};
+    auto by_buckets = dijkstra(graph, 0, buckets,
+        bucket_queue_insert<std::uint64_t>, bucket_queue_extract_min<std::uint64_t>,
+        bucket_queue_decrease_key<std::uint64_t>);
+
+    const char * names = "stxyz";
+    std::cout << "Shortest distances from s (radix heap, bucket queue)...\n";
+    for (int v = 0; v < 5; ++v)
+        std::cout << '\t' << names[v] << ": " << by_radix[v] << ", " << by_buckets[v] << '\n';
+}
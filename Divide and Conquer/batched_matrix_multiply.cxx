@@ -0,0 +1,176 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Batched Matrix Multiplication (of many small independent matrices)
+//  Worst case time complexity: O(b n^3) for b products of n x n matrices
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#include "../Instrumentation/thread_count.h"
+
+// Generalize matrices as 2D std::vector's
+template <typename T>
+using matrix = std::vector<std::vector<T>>;
+
+
+//  Multiplying one small matrix at a time leaves most of each SIMD register
+//  idle, and call overhead dominates. Instead, store a batch of matrices
+//  interleaved (structure of arrays): element (i, j) of 'Lanes' consecutive
+//  matrices sits in one contiguous run. The innermost loop then runs across
+//  matrices, so each SIMD lane computes a different product and every load
+//  is a full, unit stride vector.
+//
+//  Layout: blocks of 'Lanes' matrices, each block N*N runs of 'Lanes'
+//      data[block][i * N + j][lane]
+//  The batch is padded with zero matrices up to a whole number of blocks.
+
+template <typename T, std::size_t N, std::size_t Lanes = 16>
+class MatrixBatch {
+
+    private:
+        std::size_t count;
+        std::vector<T> data;
+
+    public:
+        static const std::size_t block_size = N * N * Lanes;
+
+        MatrixBatch(std::size_t count) : count{count},
+            data((count + Lanes - 1) / Lanes * block_size, 0) {}
+
+        std::size_t size() const { return count; }
+        std::size_t blocks() const { return data.size() / block_size; }
+
+        // Element (i, j) of matrix m
+        T & operator()(std::size_t m, std::size_t i, std::size_t j) {
+            return data[(m / Lanes) * block_size + (i * N + j) * Lanes + m % Lanes];
+        }
+
+        const T & operator()(std::size_t m, std::size_t i, std::size_t j) const {
+            return data[(m / Lanes) * block_size + (i * N + j) * Lanes + m % Lanes];
+        }
+
+        T * block(std::size_t b) { return &data[b * block_size]; }
+        const T * block(std::size_t b) const { return &data[b * block_size]; }
+
+        // Conversion to and from the row major matrix<T> type
+        void set(std::size_t m, matrix<T> const & source) {
+            for (std::size_t i = 0; i < N; ++i)
+                for (std::size_t j = 0; j < N; ++j)
+                    (*this)(m, i, j) = source[i][j];
+        }
+
+        matrix<T> get(std::size_t m) const {
+            matrix<T> result(N, std::vector<T>(N));
+            for (std::size_t i = 0; i < N; ++i)
+                for (std::size_t j = 0; j < N; ++j)
+                    result[i][j] = (*this)(m, i, j);
+            return result;
+        }
+};
+
+
+// Multiply one block of 'Lanes' matrix pairs: c = a * b, lane by lane
+// N and Lanes are compile time constants, so the loops over i, j and k
+// have fixed trip counts, and the loop over lanes becomes SIMD arithmetic
+template <typename T, std::size_t N, std::size_t Lanes>
+void multiply_block(const T * a, const T * b, T * c) {
+
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j) {
+
+            T sum[Lanes] = {};
+
+            for (std::size_t k = 0; k < N; ++k)
+                for (std::size_t lane = 0; lane < Lanes; ++lane)
+                    sum[lane] += a[(i * N + k) * Lanes + lane] * b[(k * N + j) * Lanes + lane];
+
+            for (std::size_t lane = 0; lane < Lanes; ++lane)
+                c[(i * N + j) * Lanes + lane] = sum[lane];
+        }
+    }
+}
+
+
+// Multiply blocks [first, last). Each operand is read as one unit stride
+// stream, which the hardware prefetcher follows on its own (explicit
+// software prefetches measured slower here, as they only add instructions)
+template <typename T, std::size_t N, std::size_t Lanes>
+void multiply_blocks(MatrixBatch<T, N, Lanes> const & a, MatrixBatch<T, N, Lanes> const & b,
+        MatrixBatch<T, N, Lanes> & c, std::size_t first, std::size_t last) {
+
+    for (std::size_t block = first; block < last; ++block)
+        multiply_block<T, N, Lanes>(a.block(block), b.block(block), c.block(block));
+}
+
+
+// Batched matrix multiplication algorithm: c[m] = a[m] * b[m] for every m
+// The blocks are split into contiguous ranges, one per thread. 'threads'
+// of 0 uses every hardware thread; small batches run on the caller's thread
+template <typename T, std::size_t N, std::size_t Lanes>
+void batched_matrix_multiply(MatrixBatch<T, N, Lanes> const & a, MatrixBatch<T, N, Lanes> const & b,
+        MatrixBatch<T, N, Lanes> & c, unsigned threads = 0) {
+
+    std::size_t blocks = a.blocks();
+
+    // Each thread multiplies at least this many blocks
+    const std::size_t min_blocks_per_thread = 256;
+    threads = thread_count(blocks, min_blocks_per_thread, threads);
+
+    if (threads == 1) {
+        multiply_blocks(a, b, c, 0, blocks);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        std::size_t first = blocks * t / threads;
+        std::size_t last = blocks * (t + 1) / threads;
+        workers.emplace_back([&, first, last] { multiply_blocks(a, b, c, first, last); });
+    }
+
+    for (auto & worker: workers)
+        worker.join();
+}
+
+
+// Convenience output formatter
+template <typename T>
+void print_matrix(matrix<T> const & matrix) {
+
+    for (auto row: matrix) {
+        for (auto element: row)
+            std::cout << element << '\t';
+        std::cout << '\n';
+    }
+
+    std::cout << std::endl;
+}
+
+// Demonstration
+int main(int argc, char * argv[]) {
+
+    const std::size_t count = 100000;
+
+    MatrixBatch<float, 4> a{count}, b{count}, c{count};
+
+    // Every matrix in 'a' is the same 4x4 matrix scaled by its position
+    // in the batch, and every matrix in 'b' is the identity times 2
+    for (std::size_t m = 0; m < count; ++m)
+        for (std::size_t i = 0; i < 4; ++i) {
+            for (std::size_t j = 0; j < 4; ++j)
+                a(m, i, j) = (m % 10) * (i * 4 + j + 1);
+            b(m, i, i) = 2;
+        }
+
+    batched_matrix_multiply(a, b, c);
+
+    std::cout << "Matrix a[3]...\n";
+    print_matrix(a.get(3));
+    std::cout << "Result of multiplying a[3] by b[3]...\n";
+    print_matrix(c.get(3));
+}
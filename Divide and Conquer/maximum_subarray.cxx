@@ -12,6 +12,7 @@
 #include <iostream>
 #include <vector>
 #include <tuple>
+#include <climits>
 
 //  Given an array of comparable elements, the algorithm recursively
 //  determines the subarray that produces the largest sum. The largest
@@ -4,6 +4,8 @@
 //
 //  Merge Sort (pg. 31, 34)
 //  Worst case time complexity: O(n log(n))
+//  Adaptive (natural) merge sort: O(n) on presorted input, O(n log(n)) worst case
+//  In place merge sort: O(n log^2(n)) worst case, O(sqrt(n)) extra space
 //
 //  Implemented by Joel Rorseth
 //  Created on May 4, 2017
@@ -11,30 +13,42 @@
 
 #include <iostream>
 #include <vector>
+#include <climits>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "../Instrumentation/instrumentation.h"
 
 
 //  Given two sorted lists [p,q] and (q,r], merge together into
 //  one sorted list. Load both ranges into two sublists, and compare
 //  both lists at each index to determine which value to copy to 'list'
+//  Comparisons, copies and allocations are reported to 'Instrument'
 
-template <typename T>
+template <typename Instrument = no_instrumentation, typename T>
 void merge(std::vector<T> & list, int p, int q, int r) {
 
+    typename Instrument::scope sample{"merge"};
+
     auto n1 = q - p + 1;
     auto n2 = r - q;
 
-    // Create temporary lists
-    std::vector<T> l_list{};
-    std::vector<T> r_list{};
-    
-    l_list.reserve(n1 + 1);
-    r_list.reserve(n2 + 1);
+    // Create temporary lists, with room for the sentinel at the end
+    std::vector<T> l_list(n1 + 1);
+    std::vector<T> r_list(n2 + 1);
+
+    Instrument::allocate((n1 + 1) * sizeof(T));
+    Instrument::allocate((n2 + 1) * sizeof(T));
 
     for (int i = 0; i < n1; i++) 
         l_list[i] = list[p + i];
     for (int j = 0; j < n2; j++)
         r_list[j] = list[q + j + 1];
 
+    // Every element is copied out here, and back again below
+    Instrument::move(2 * (n1 + n2));
+
     l_list[n1] = INT_MAX;
     r_list[n2] = INT_MAX;
 
@@ -47,12 +61,12 @@ void merge(std::vector<T> & list, int p, int q, int r) {
         // Determine if next sorted value should be from
         // left or right sublists, then copy to original list
 
-        if (l_list[i] <= r_list[j]) {
+        if (Instrument::compare(l_list[i] <= r_list[j])) {
 
             list[k] = l_list[i];
             ++i;
 
-        } else if (l_list[i] > r_list[j]) {
+        } else {
 
             list[k] = r_list[j];
             ++j;
@@ -65,18 +79,480 @@ void merge(std::vector<T> & list, int p, int q, int r) {
 //  split left and right halves of list. Eventually, both halves will be
 //  merged back sorted, starting with the lists containing one element.
 
-template <typename T>
+template <typename Instrument = no_instrumentation, typename T>
 void merge_sort(std::vector<T> & list, int p, int r) {
 
     // Keep recursively calling until there is one element in [p, r]
     if (p < r) {
 
         auto q = (p + r) / 2;
-        merge_sort(list, p, q);
-        merge_sort(list, q + 1, r);
+        merge_sort<Instrument>(list, p, q);
+        merge_sort<Instrument>(list, q + 1, r);
+
+        merge<Instrument>(list, p, q, r);
+    }
+}
+
+
+//  Adaptive (natural) merge sort, in the style of TimSort
+//  Rather than always splitting at (p + r) / 2, find the runs that are
+//  already in order and only merge those. Sorted input is a single run
+//  and takes O(n) time; input with a few out of order bursts costs little
+//  more than the bursts themselves. Worst case time remains O(n log(n)).
+
+
+//  Find the run starting at list[p], no further than list[r]. Runs are
+//  non-decreasing, or strictly decreasing (reversed here; the strictness
+//  keeps the sort stable). Returns the index of the run's last element
+template <typename Instrument = no_instrumentation, typename T>
+int find_run(std::vector<T> & list, int p, int r) {
+
+    int end = p + 1;
+    if (end > r)
+        return p;
+
+    if (Instrument::compare(list[end] < list[p])) {
+        while (end < r && Instrument::compare(list[end + 1] < list[end]))
+            ++end;
+        std::reverse(list.begin() + p, list.begin() + end + 1);
+        Instrument::move(end - p + 1);
+    } else {
+        while (end < r && !Instrument::compare(list[end + 1] < list[end]))
+            ++end;
+    }
+
+    return end;
+}
+
+
+//  Binary insertion sort of [p, r], given that [p, sorted] is in order
+//  Used to extend short runs to the minimum run length
+template <typename Instrument = no_instrumentation, typename T>
+void binary_insertion_sort(std::vector<T> & list, int p, int sorted, int r) {
+
+    for (int j = sorted + 1; j <= r; ++j) {
+
+        T key = list[j];
+
+        // Insert after any equal keys, to keep the sort stable
+        int low = p, high = j;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (Instrument::compare(key < list[mid]))
+                high = mid;
+            else
+                low = mid + 1;
+        }
+
+        std::move_backward(list.begin() + low, list.begin() + j, list.begin() + j + 1);
+        list[low] = key;
+        Instrument::move(j - low + 1);
+    }
+}
+
+
+//  Galloping (exponential) search over [p, r] for the first index at which
+//  'before' turns false, given that it holds for a prefix of the range.
+//  Probes 1, 3, 7, ... from the left (or from the right, if 'from_right')
+//  before a binary search, so the cost is O(log d) when the answer is d
+//  from the end the search starts at. Returns r + 1 if 'before' always holds
+template <typename Before>
+int gallop(int p, int r, bool from_right, Before before) {
+
+    int low = p, high = r + 1;
+
+    if (!from_right) {
+        int probe = p;
+        while (probe <= r && before(probe)) {
+            low = probe + 1;
+            probe = p + 2 * (probe - p) + 1;
+        }
+        high = std::min(probe, r + 1);
+    } else {
+        int probe = r;
+        while (probe >= p && !before(probe)) {
+            high = probe;
+            probe = r - 2 * (r - probe) - 1;
+        }
+        low = std::max(probe + 1, p);
+    }
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (before(mid))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
 
-        merge(list, p, q, r);
+//  First element of [p, r] that is greater than 'key'
+template <typename Instrument = no_instrumentation, typename T>
+int gallop_upper(const std::vector<T> & list, const T & key, int p, int r, bool from_right = false) {
+    return gallop(p, r, from_right, [&](int i) { return !Instrument::compare(key < list[i]); });
+}
+
+//  First element of [p, r] that is no less than 'key'
+template <typename Instrument = no_instrumentation, typename T>
+int gallop_lower(const std::vector<T> & list, const T & key, int p, int r, bool from_right = false) {
+    return gallop(p, r, from_right, [&](int i) { return Instrument::compare(list[i] < key); });
+}
+
+
+//  A run that wins this many comparisons in a row switches the merge to
+//  galloping, which moves whole stretches of it at once
+const int min_gallop = 7;
+
+//  Merge [p, q] and (q, r] from the front, with the left run (the shorter
+//  one) in 'buffer'. Ties go left, so the merge is stable
+template <typename Instrument = no_instrumentation, typename T>
+void merge_low(std::vector<T> & list, int p, int q, int r, std::vector<T> & buffer) {
+
+    int n1 = q - p + 1;
+
+    if (n1 > int(buffer.capacity()))
+        Instrument::allocate((n1 - buffer.capacity()) * sizeof(T));
+    buffer.assign(list.begin() + p, list.begin() + q + 1);
+    Instrument::move(n1);
+
+    int i = 0, j = q + 1, k = p;
+
+    while (i < n1 && j <= r) {
+
+        // One element at a time, until one run wins min_gallop times in a row
+        int left_wins = 0, right_wins = 0;
+        while (i < n1 && j <= r && left_wins < min_gallop && right_wins < min_gallop) {
+            if (Instrument::compare(list[j] < buffer[i])) {
+                list[k++] = list[j++];
+                ++right_wins;
+                left_wins = 0;
+            } else {
+                list[k++] = buffer[i++];
+                ++left_wins;
+                right_wins = 0;
+            }
+            Instrument::move(1);
+        }
+
+        // Then gallop, until both runs win only short stretches again
+        while (i < n1 && j <= r) {
+
+            // Left keys no greater than the next right key
+            int end = gallop_upper<Instrument>(buffer, list[j], i, n1 - 1);
+            std::copy(buffer.begin() + i, buffer.begin() + end, list.begin() + k);
+            Instrument::move(end - i);
+            left_wins = end - i;
+            k += left_wins;
+            i = end;
+            if (i == n1)
+                break;
+
+            // Right keys less than the next left key (k < j, so this
+            // copies forward safely within 'list')
+            end = gallop_lower<Instrument>(list, buffer[i], j, r);
+            std::copy(list.begin() + j, list.begin() + end, list.begin() + k);
+            Instrument::move(end - j);
+            right_wins = end - j;
+            k += right_wins;
+            j = end;
+
+            if (left_wins < min_gallop && right_wins < min_gallop)
+                break;
+        }
+    }
+
+    // Whatever is left of the right run is already in place
+    std::copy(buffer.begin() + i, buffer.begin() + n1, list.begin() + k);
+    Instrument::move(n1 - i);
+}
+
+//  Merge [p, q] and (q, r] from the back, with the right run (the shorter
+//  one) in 'buffer'. Ties go right, so the merge is stable
+template <typename Instrument = no_instrumentation, typename T>
+void merge_high(std::vector<T> & list, int p, int q, int r, std::vector<T> & buffer) {
+
+    int n2 = r - q;
+
+    if (n2 > int(buffer.capacity()))
+        Instrument::allocate((n2 - buffer.capacity()) * sizeof(T));
+    buffer.assign(list.begin() + q + 1, list.begin() + r + 1);
+    Instrument::move(n2);
+
+    int i = q, j = n2 - 1, k = r;
+
+    while (i >= p && j >= 0) {
+
+        int left_wins = 0, right_wins = 0;
+        while (i >= p && j >= 0 && left_wins < min_gallop && right_wins < min_gallop) {
+            if (Instrument::compare(buffer[j] < list[i])) {
+                list[k--] = list[i--];
+                ++left_wins;
+                right_wins = 0;
+            } else {
+                list[k--] = buffer[j--];
+                ++right_wins;
+                left_wins = 0;
+            }
+            Instrument::move(1);
+        }
+
+        while (i >= p && j >= 0) {
+
+            // Left keys greater than the next right key (k > i, so
+            // copying backward is safe within 'list')
+            int start = gallop_upper<Instrument>(list, buffer[j], p, i, true);
+            std::copy_backward(list.begin() + start, list.begin() + i + 1, list.begin() + k + 1);
+            Instrument::move(i + 1 - start);
+            left_wins = i + 1 - start;
+            k -= left_wins;
+            i = start - 1;
+            if (i < p)
+                break;
+
+            // Right keys no less than the next left key
+            start = gallop_lower<Instrument>(buffer, list[i], 0, j, true);
+            std::copy(buffer.begin() + start, buffer.begin() + j + 1, list.begin() + k - (j - start));
+            Instrument::move(j + 1 - start);
+            right_wins = j + 1 - start;
+            k -= right_wins;
+            j = start - 1;
+
+            if (left_wins < min_gallop && right_wins < min_gallop)
+                break;
+        }
     }
+
+    // Whatever is left of the left run is already in place
+    std::copy(buffer.begin(), buffer.begin() + j + 1, list.begin() + p);
+    Instrument::move(j + 1);
+}
+
+
+//  Merge adjacent sorted runs [p, q] and (q, r]. Elements at the start of
+//  the left run that are no greater than the right run's first element,
+//  and elements at the end of the right run that are no less than the left
+//  run's last element, are already in place. Gallop past both, then merge
+//  what is left through 'buffer', copying out only the shorter run. Runs
+//  that are already in order cost O(log n); runs that interleave in long
+//  stretches cost O(log d) per stretch of d rather than d comparisons
+template <typename Instrument = no_instrumentation, typename T>
+void merge_runs(std::vector<T> & list, int p, int q, int r, std::vector<T> & buffer) {
+
+    p = gallop_upper<Instrument>(list, list[q + 1], p, q);
+    if (p > q)
+        return;
+
+    r = gallop_lower<Instrument>(list, list[q], q + 1, r, true) - 1;
+
+    if (q - p + 1 <= r - q)
+        merge_low<Instrument>(list, p, q, r, buffer);
+    else
+        merge_high<Instrument>(list, p, q, r, buffer);
+}
+
+
+//  Minimum run length for n elements: between 32 and 64, and chosen so
+//  that n / min_run is close to (but no more than) a power of 2, which
+//  keeps the final merges balanced
+inline int min_run_length(int n) {
+
+    int remainder = 0;
+    while (n >= 64) {
+        remainder |= n & 1;
+        n >>= 1;
+    }
+    return n + remainder;
+}
+
+
+template <typename Instrument = no_instrumentation, typename T>
+void adaptive_merge_sort(std::vector<T> & list, int p, int r) {
+
+    // Pending runs, as (first index, length), waiting to be merged, and
+    // the merge buffer, which grows to the shorter run of any merge
+    std::vector<std::pair<int, int>> runs;
+    std::vector<T> buffer;
+
+    auto merge_at = [&](int i) {
+        auto & left = runs[i];
+        auto & right = runs[i + 1];
+
+        merge_runs<Instrument>(list, left.first, left.first + left.second - 1,
+            right.first + right.second - 1, buffer);
+
+        left.second += right.second;
+        runs.erase(runs.begin() + i + 1);
+    };
+
+    // Keep run lengths on the stack decreasing at least as fast as the
+    // Fibonacci numbers (len[i - 2] > len[i - 1] + len[i], len[i - 1] > len[i]),
+    // so the stack stays O(log n) deep and merges stay balanced
+    auto collapse = [&]() {
+        while (runs.size() > 1) {
+            int n = runs.size() - 2;
+
+            if ((n > 0 && runs[n - 1].second <= runs[n].second + runs[n + 1].second) ||
+                    (n > 1 && runs[n - 2].second <= runs[n - 1].second + runs[n].second)) {
+                if (runs[n - 1].second < runs[n + 1].second)
+                    --n;
+                merge_at(n);
+            } else if (runs[n].second <= runs[n + 1].second) {
+                merge_at(n);
+            } else {
+                break;
+            }
+        }
+    };
+
+    int min_run = min_run_length(r - p + 1);
+
+    for (int start = p; start <= r; ) {
+
+        int end = find_run<Instrument>(list, start, r);
+
+        // Extend short runs to min_run elements with binary insertion sort
+        if (end - start + 1 < min_run) {
+            int forced = std::min(r, start + min_run - 1);
+            binary_insertion_sort<Instrument>(list, start, end, forced);
+            end = forced;
+        }
+
+        runs.push_back({start, end - start + 1});
+        collapse();
+
+        start = end + 1;
+    }
+
+    // Merge whatever remains, newest runs first
+    while (runs.size() > 1)
+        merge_at(runs.size() - 2);
+}
+
+
+//  In place stable merge sort
+//  merge() copies both runs out, so the last merge alone needs n extra
+//  elements, doubling peak memory. The merge below works in place: when
+//  the shorter run fits in a small buffer it is merged through that
+//  buffer as usual; otherwise the longer run is split at its middle key,
+//  the other run is split where that key belongs, and the two inner
+//  pieces are swapped with a rotation, leaving two smaller independent
+//  merges. With a buffer of sqrt(n) elements, all but the largest merges
+//  run at buffered speed. Equal keys never pass each other, so the sort
+//  stays stable.
+
+
+//  Merge [p, q] and (q, r] in place, using 'buffer' when the shorter run
+//  fits in it (an empty buffer gives a purely rotation based merge)
+template <typename Instrument = no_instrumentation, typename T>
+void merge_in_place(std::vector<T> & list, int p, int q, int r, std::vector<T> & buffer) {
+
+    int n1 = q - p + 1;
+    int n2 = r - q;
+
+    // Nothing to merge, or the runs are already in order
+    if (n1 <= 0 || n2 <= 0 || !Instrument::compare(list[q + 1] < list[q]))
+        return;
+
+    if (n1 + n2 == 2) {
+        Instrument::swap(list[p], list[r]);
+        return;
+    }
+
+    // Left run in the buffer, merged from the front (ties go left)
+    if (n1 <= int(buffer.size())) {
+
+        std::copy(list.begin() + p, list.begin() + q + 1, buffer.begin());
+        Instrument::move(n1 + n1 + n2);
+
+        int i = 0, j = q + 1, k = p;
+        while (i < n1 && j <= r)
+            list[k++] = Instrument::compare(list[j] < buffer[i]) ? list[j++] : buffer[i++];
+        while (i < n1)
+            list[k++] = buffer[i++];
+        return;
+    }
+
+    // Right run in the buffer, merged from the back (ties go right)
+    if (n2 <= int(buffer.size())) {
+
+        std::copy(list.begin() + q + 1, list.begin() + r + 1, buffer.begin());
+        Instrument::move(n2 + n1 + n2);
+
+        int i = q, j = n2 - 1, k = r;
+        while (i >= p && j >= 0)
+            list[k--] = Instrument::compare(buffer[j] < list[i]) ? list[i--] : buffer[j--];
+        while (j >= 0)
+            list[k--] = buffer[j--];
+        return;
+    }
+
+    // Split the longer run at its middle, and the other run where that
+    // key belongs: keys equal to it stay on their own side of it
+    int left_cut, right_cut;
+
+    if (n1 >= n2) {
+        left_cut = p + n1 / 2;
+        int low = q + 1, high = r + 1;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (Instrument::compare(list[mid] < list[left_cut]))
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        right_cut = low;
+    } else {
+        right_cut = q + 1 + n2 / 2;
+        int low = p, high = q + 1;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (Instrument::compare(list[right_cut] < list[mid]))
+                high = mid;
+            else
+                low = mid + 1;
+        }
+        left_cut = low;
+    }
+
+    // [left_cut, q] and (q, right_cut) trade places
+    std::rotate(list.begin() + left_cut, list.begin() + q + 1, list.begin() + right_cut);
+    Instrument::move(right_cut - left_cut);
+
+    int middle = left_cut + (right_cut - q - 1);
+
+    merge_in_place<Instrument>(list, p, left_cut - 1, middle - 1, buffer);
+    merge_in_place<Instrument>(list, middle, middle + (q - left_cut), r, buffer);
+}
+
+
+//  Bottom up: sort blocks of 32 with binary insertion sort, then merge
+//  pairs of blocks of doubling width. Extra space is the buffer alone,
+//  'buffer_size' elements (by default sqrt(n)); recursion in the merge
+//  is O(log(n)) deep
+template <typename Instrument = no_instrumentation, typename T>
+void merge_sort_in_place(std::vector<T> & list, int p, int r, int buffer_size = -1) {
+
+    typename Instrument::scope sample{"merge_sort_in_place"};
+
+    int n = r - p + 1;
+    if (n < 2)
+        return;
+
+    if (buffer_size < 0)
+        buffer_size = std::sqrt(double(n));
+
+    std::vector<T> buffer(buffer_size);
+    Instrument::allocate(buffer_size * sizeof(T));
+
+    const int block = 32;
+    for (int low = p; low <= r; low += block)
+        binary_insertion_sort<Instrument>(list, low, low, std::min(low + block - 1, r));
+
+    for (int width = block; width < n; width *= 2)
+        for (int low = p; low + width <= r; low += 2 * width)
+            merge_in_place<Instrument>(list, low, low + width - 1, std::min(low + 2 * width - 1, r), buffer);
 }
 
 
@@ -99,4 +575,27 @@ int main(int argc, char * argv[]) {
     for (auto num: a)
         std::cout << num << ", ";
     std::cout << "}" << std::endl;
+
+    // A mostly sorted list, with a descending run and one out of order burst
+    std::vector<int> b{1,2,3,4,5,6,7,8,9,10,15,14,13,12,11,16,17,20,18,19,21,22};
+
+    adaptive_merge_sort(b, 0, b.size() - 1);
+
+    std::cout << "After adaptive sorting...\n\tstd::vector b = { ";
+    for (auto num: b)
+        std::cout << num << ", ";
+    std::cout << "}" << std::endl;
+
+    // Sort in place, with a buffer of just 2 elements (the 40 keys are
+    // more than one block of 32, so some merging is done)
+    std::vector<int> c;
+    for (int i = 0; i < 40; ++i)
+        c.push_back(i * 7 % 40 / 2);
+
+    merge_sort_in_place(c, 0, c.size() - 1, 2);
+
+    std::cout << "After in place sorting...\n\tstd::vector c = { ";
+    for (auto num: c)
+        std::cout << num << ", ";
+    std::cout << "}" << std::endl;
 }
@@ -0,0 +1,302 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Sparse Matrix Multiplication (CSR/CSC, Gustavson's algorithm)
+//  Worst case time complexity: O(flops + nnz), where flops is the number
+//  of nonzero products a[i][k] * b[k][j]
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <thread>
+
+#include "../Instrumentation/thread_count.h"
+
+// Generalize matrices as 2D std::vector's
+template <typename T>
+using matrix = std::vector<std::vector<T>>;
+
+
+//  Compressed Sparse Row: only the nonzero entries are stored, row by row.
+//  Row i's entries are values[row_start[i] .. row_start[i + 1]), and
+//  col_index holds the column of each entry, in increasing order
+template <typename T>
+struct CsrMatrix {
+    std::size_t rows, cols;
+    std::vector<std::size_t> row_start;
+    std::vector<std::size_t> col_index;
+    std::vector<T> values;
+};
+
+//  Compressed Sparse Column: the same idea, column by column
+template <typename T>
+struct CscMatrix {
+    std::size_t rows, cols;
+    std::vector<std::size_t> col_start;
+    std::vector<std::size_t> row_index;
+    std::vector<T> values;
+};
+
+
+
+// Conversion from a dense matrix, keeping only the nonzero entries
+template <typename T>
+CsrMatrix<T> to_csr(matrix<T> const & dense) {
+
+    CsrMatrix<T> sparse{dense.size(), dense.empty() ? 0 : dense[0].size(), {0}, {}, {}};
+
+    for (auto & row: dense) {
+        for (std::size_t j = 0; j < row.size(); ++j)
+            if (row[j] != T{}) {
+                sparse.col_index.push_back(j);
+                sparse.values.push_back(row[j]);
+            }
+        sparse.row_start.push_back(sparse.values.size());
+    }
+
+    return sparse;
+}
+
+template <typename T>
+CscMatrix<T> to_csc(matrix<T> const & dense) {
+
+    CscMatrix<T> sparse{dense.size(), dense.empty() ? 0 : dense[0].size(), {0}, {}, {}};
+
+    for (std::size_t j = 0; j < sparse.cols; ++j) {
+        for (std::size_t i = 0; i < sparse.rows; ++i)
+            if (dense[i][j] != T{}) {
+                sparse.row_index.push_back(i);
+                sparse.values.push_back(dense[i][j]);
+            }
+        sparse.col_start.push_back(sparse.values.size());
+    }
+
+    return sparse;
+}
+
+// Conversion between the two sparse formats (a counting sort by column)
+template <typename T>
+CscMatrix<T> to_csc(CsrMatrix<T> const & a) {
+
+    CscMatrix<T> b{a.rows, a.cols, std::vector<std::size_t>(a.cols + 1, 0),
+        std::vector<std::size_t>(a.values.size()), std::vector<T>(a.values.size())};
+
+    for (auto j: a.col_index)
+        ++b.col_start[j + 1];
+    for (std::size_t j = 0; j < a.cols; ++j)
+        b.col_start[j + 1] += b.col_start[j];
+
+    // Rows are visited in order, so each column's row indexes stay sorted
+    std::vector<std::size_t> next(b.col_start.begin(), b.col_start.end() - 1);
+    for (std::size_t i = 0; i < a.rows; ++i)
+        for (auto e = a.row_start[i]; e < a.row_start[i + 1]; ++e) {
+            auto position = next[a.col_index[e]]++;
+            b.row_index[position] = i;
+            b.values[position] = a.values[e];
+        }
+
+    return b;
+}
+
+// Conversion back to a dense matrix
+template <typename T>
+matrix<T> to_dense(CsrMatrix<T> const & sparse) {
+
+    matrix<T> dense(sparse.rows, std::vector<T>(sparse.cols, T{}));
+    for (std::size_t i = 0; i < sparse.rows; ++i)
+        for (auto e = sparse.row_start[i]; e < sparse.row_start[i + 1]; ++e)
+            dense[i][sparse.col_index[e]] = sparse.values[e];
+    return dense;
+}
+
+template <typename T>
+matrix<T> to_dense(CscMatrix<T> const & sparse) {
+
+    matrix<T> dense(sparse.rows, std::vector<T>(sparse.cols, T{}));
+    for (std::size_t j = 0; j < sparse.cols; ++j)
+        for (auto e = sparse.col_start[j]; e < sparse.col_start[j + 1]; ++e)
+            dense[sparse.row_index[e]][j] = sparse.values[e];
+    return dense;
+}
+
+
+
+// Each thread performs at least this many multiply-adds
+const std::size_t min_work_per_thread = 1 << 16;
+
+// Split [0, n) into contiguous ranges and run 'work(first, last)' on each,
+// one range per thread (as chosen by thread_count)
+template <typename Work>
+void parallel_ranges(std::size_t n, unsigned threads, Work work) {
+
+    if (threads == 1) {
+        work(0, n);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back(work, n * t / threads, n * (t + 1) / threads);
+
+    for (auto & worker: workers)
+        worker.join();
+}
+
+
+// Sparse x dense multiplication: c[i] = summation over nonzero a[i][k] of
+// a[i][k] * b[k]. Each nonzero scales one whole row of b, so zeros cost
+// nothing. Rows of c are independent and are computed in parallel
+template <typename T>
+matrix<T> sparse_dense_multiply(CsrMatrix<T> const & a, matrix<T> const & b, unsigned threads = 0) {
+
+    std::size_t cols = b.empty() ? 0 : b[0].size();
+    matrix<T> c(a.rows, std::vector<T>(cols, T{}));
+
+    threads = thread_count(a.values.size() * cols, min_work_per_thread, threads, a.rows);
+
+    parallel_ranges(a.rows, threads, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+            for (auto e = a.row_start[i]; e < a.row_start[i + 1]; ++e) {
+                auto & row = b[a.col_index[e]];
+                for (std::size_t j = 0; j < cols; ++j)
+                    c[i][j] += a.values[e] * row[j];
+            }
+    });
+
+    return c;
+}
+
+// Dense x sparse multiplication: column j of c only depends on the
+// nonzeros of column j of b, which CSC stores contiguously
+template <typename T>
+matrix<T> dense_sparse_multiply(matrix<T> const & a, CscMatrix<T> const & b, unsigned threads = 0) {
+
+    matrix<T> c(a.size(), std::vector<T>(b.cols, T{}));
+
+    threads = thread_count(a.size() * b.values.size(), min_work_per_thread, threads, a.size());
+
+    parallel_ranges(a.size(), threads, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+            for (std::size_t j = 0; j < b.cols; ++j) {
+                T sum{};
+                for (auto e = b.col_start[j]; e < b.col_start[j + 1]; ++e)
+                    sum += a[i][b.row_index[e]] * b.values[e];
+                c[i][j] = sum;
+            }
+    });
+
+    return c;
+}
+
+
+// Sparse x sparse multiplication (Gustavson's algorithm)
+// Row i of c is the sum of rows b[k] scaled by each nonzero a[i][k]. The
+// row is gathered in a dense accumulator, with a list of the columns it
+// touched, so clearing it afterwards costs only the entries produced.
+// Each thread builds its rows separately; they are then concatenated
+template <typename T>
+CsrMatrix<T> sparse_matrix_multiply(CsrMatrix<T> const & a, CsrMatrix<T> const & b,
+        unsigned threads = 0) {
+
+    struct partial {
+        std::vector<std::size_t> row_length, col_index;
+        std::vector<T> values;
+    };
+
+    // The work is the number of multiply-adds, one per nonzero of b in each
+    // row b[k] that a nonzero a[i][k] selects
+    std::size_t flops = 0;
+    for (auto k: a.col_index)
+        flops += b.row_start[k + 1] - b.row_start[k];
+
+    threads = thread_count(flops, min_work_per_thread, threads, a.rows);
+
+    std::vector<partial> parts(threads);
+
+    parallel_ranges(threads, threads, [&](std::size_t first_part, std::size_t last_part) {
+        for (auto p = first_part; p < last_part; ++p) {
+
+            auto & part = parts[p];
+            std::vector<T> accumulator(b.cols, T{});
+            std::vector<bool> occupied(b.cols, false);
+            std::vector<std::size_t> touched;
+
+            for (auto i = a.rows * p / threads; i < a.rows * (p + 1) / threads; ++i) {
+
+                for (auto e = a.row_start[i]; e < a.row_start[i + 1]; ++e) {
+                    auto k = a.col_index[e];
+
+                    for (auto f = b.row_start[k]; f < b.row_start[k + 1]; ++f) {
+                        auto j = b.col_index[f];
+                        if (!occupied[j]) {
+                            occupied[j] = true;
+                            touched.push_back(j);
+                        }
+                        accumulator[j] += a.values[e] * b.values[f];
+                    }
+                }
+
+                // Emit the row in column order, then reset what was touched
+                std::sort(touched.begin(), touched.end());
+                for (auto j: touched) {
+                    part.col_index.push_back(j);
+                    part.values.push_back(accumulator[j]);
+                    accumulator[j] = T{};
+                    occupied[j] = false;
+                }
+
+                part.row_length.push_back(touched.size());
+                touched.clear();
+            }
+        }
+    });
+
+    CsrMatrix<T> c{a.rows, b.cols, {0}, {}, {}};
+    for (auto & part: parts) {
+        for (auto length: part.row_length)
+            c.row_start.push_back(c.row_start.back() + length);
+        c.col_index.insert(c.col_index.end(), part.col_index.begin(), part.col_index.end());
+        c.values.insert(c.values.end(), part.values.begin(), part.values.end());
+    }
+
+    return c;
+}
+
+
+// Convenience output formatter
+template <typename T>
+void print_matrix(matrix<T> const & matrix) {
+
+    for (auto row: matrix) {
+        for (auto element: row)
+            std::cout << element << '\t';
+        std::cout << '\n';
+    }
+
+    std::cout << std::endl;
+}
+
+// Demonstration
+int main(int argc, char * argv[]) {
+
+    matrix<int> a{
+        {1,0,0,2}, {0,0,3,0}, {0,0,0,0}, {4,0,0,5}};
+    matrix<int> b{
+        {0,6,0,0}, {7,0,0,0}, {0,0,8,0}, {0,9,0,1}};
+
+    auto sparse_a = to_csr(a);
+    auto sparse_b = to_csr(b);
+
+    std::cout << "Matrix a (" << sparse_a.values.size() << " nonzeros)...\n";
+    print_matrix(a);
+    std::cout << "Matrix b (" << sparse_b.values.size() << " nonzeros)...\n";
+    print_matrix(b);
+
+    std::cout << "Result of multiplying sparse a by sparse b...\n";
+    print_matrix(to_dense(sparse_matrix_multiply(sparse_a, sparse_b)));
+
+    std::cout << "Result of multiplying sparse a by dense b...\n";
+    print_matrix(sparse_dense_multiply(sparse_a, b));
+}
@@ -11,6 +11,8 @@
 
 #include <iostream>
 #include <vector>
+#include <array>
+#include <utility>
 
 // Generalize matrices as 2D std::vector's
 template <typename T>
@@ -27,7 +29,7 @@ matrix<T> square_matrix_multiply(matrix<T> const & a, matrix<T> const & b) {
     auto n = a.size();
    
     // Matrix must be initialized with default values and size n
-    matrix<T> c{{0,0,0,0}, {0,0,0,0}, {0,0,0,0}, {0,0,0,0}};
+    matrix<T> c(n, std::vector<T>(n, 0));
 
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < n; ++j) {
@@ -42,6 +44,45 @@ matrix<T> square_matrix_multiply(matrix<T> const & a, matrix<T> const & b) {
 }
 
 
+
+// Small matrices (e.g. 3x3 and 4x4 transforms) of a size known at compile
+// time. Elements are stored row major in one std::array, so a product
+// needs no heap allocation, and the multiply below is expanded entirely
+// at compile time: there are no loops or bounds for the compiler to keep,
+// so results can stay in registers and the row arithmetic is vectorized
+template <typename T, std::size_t N>
+struct FixedMatrix {
+
+    std::array<T, N * N> elements;
+
+    constexpr T & operator()(std::size_t i, std::size_t j) { return elements[i * N + j]; }
+    constexpr const T & operator()(std::size_t i, std::size_t j) const { return elements[i * N + j]; }
+};
+
+
+// c[i][j] = summation from k=1 to n(a[i][k] * b[k][j]), with the sum
+// over k expanded into a fold expression
+template <typename T, std::size_t N, std::size_t... K>
+constexpr T fixed_dot_product(FixedMatrix<T, N> const & a, FixedMatrix<T, N> const & b,
+        std::size_t i, std::size_t j, std::index_sequence<K...>) {
+    return ((a(i, K) * b(K, j)) + ...);
+}
+
+// Produce every element of the result from one pack of N*N indexes
+template <typename T, std::size_t N, std::size_t... E>
+constexpr FixedMatrix<T, N> fixed_multiply(FixedMatrix<T, N> const & a,
+        FixedMatrix<T, N> const & b, std::index_sequence<E...>) {
+    return {{ fixed_dot_product(a, b, E / N, E % N, std::make_index_sequence<N>{})... }};
+}
+
+// Matrix multiplication algorithm for fixed size matrices
+template <typename T, std::size_t N>
+constexpr FixedMatrix<T, N> square_matrix_multiply(FixedMatrix<T, N> const & a,
+        FixedMatrix<T, N> const & b) {
+    return fixed_multiply(a, b, std::make_index_sequence<N * N>{});
+}
+
+
 // Convenience output formatter
 template <typename T>
 void print_matrix(matrix<T> const & matrix) {
@@ -55,6 +96,18 @@ void print_matrix(matrix<T> const & matrix) {
     std::cout << std::endl;
 }
 
+template <typename T, std::size_t N>
+void print_matrix(FixedMatrix<T, N> const & matrix) {
+
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = 0; j < N; ++j)
+            std::cout << matrix(i, j) << '\t';
+        std::cout << '\n';
+    }
+
+    std::cout << std::endl;
+}
+
 // Demonstration
 int main(int argc, char * argv[]) {
 
@@ -72,4 +125,16 @@ int main(int argc, char * argv[]) {
     
     auto multiplied = square_matrix_multiply(a, b);
     print_matrix(multiplied);
+
+    // The same product with fixed size matrices, evaluated at compile time
+    constexpr FixedMatrix<int, 4> fixed_a{{
+        1,2,3,4, 5,6,7,8, 9,10,11,12, 13,14,15,16}};
+    constexpr FixedMatrix<int, 4> fixed_b{{
+        0,2,4,6, 8,10,12,14, 16,18,20,22, 24,26,28,30}};
+
+    constexpr auto fixed_multiplied = square_matrix_multiply(fixed_a, fixed_b);
+    static_assert(fixed_multiplied(0, 0) == 160, "constexpr multiply");
+
+    std::cout << "Result of multiplying fixed size matrix a by b...\n";
+    print_matrix(fixed_multiplied);
 }
@@ -5,12 +5,17 @@
 //  Recursive Matrix Multiplication Algorithm (pg. 77)
 //  Worst case time complexity: O(n^3)
 //
+//  Cache oblivious variant on Morton (Z-order) layout matrices
+//  Worst case time complexity: O(n^3), with O(n^3 / (B sqrt(M))) cache
+//  misses for cache size M and line size B
+//
 //  Implemented by Joel Rorseth
 //  Created on May 21, 2017
 //
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 // Note: For simplicity, this algorithm will only work for n x n
 // matrices where n is a power of 2. This is to make sure that after
@@ -98,6 +103,152 @@ matrix<T> square_matrix_multiply_recursive(const matrix<T> & a, const matrix<T>
     return c;
 }
 
+// Cache oblivious recursive multiplication in Morton (Z-order) layout
+// Above, every quadrant is a scattered set of rows, and every call
+// allocates its own result. Here the matrix is stored so that each
+// quadrant, at every level of the recursion, is one contiguous block:
+// the four quadrants are stored one after another in the order
+// top-left, top-right, bottom-left, bottom-right, and each quadrant is
+// stored the same way. The recursion stops at small tiles, which are
+// stored row major. Whatever the cache sizes are, some level of the
+// recursion fits in each of them, so no per-machine tuning is needed.
+
+
+// A matrix in Morton layout: 'size' x 'size' elements, stored as a
+// 'padded' x 'padded' matrix of 'tile' x 'tile' row major tiles. Both
+// 'padded' and 'tile' are powers of 2, so the quadrants always halve
+// evenly; the padding is zero, and contributes nothing to a product
+template <typename T>
+struct MortonMatrix {
+    int size;
+    int padded;
+    int tile;
+    std::vector<T> elements;
+};
+
+
+// Interleave the bits of a tile's row and column, giving its position
+// along the Z-order curve (row bits take the more significant place)
+inline std::size_t morton_index(std::size_t row, std::size_t col) {
+
+    std::size_t index = 0;
+    for (int bit = 0; (row >> bit) || (col >> bit); ++bit) {
+        index |= ((col >> bit) & 1) << (2 * bit);
+        index |= ((row >> bit) & 1) << (2 * bit + 1);
+    }
+    return index;
+}
+
+// Position of element (i, j) within a Morton layout
+inline std::size_t morton_offset(int i, int j, int tile) {
+    return morton_index(i / tile, j / tile) * tile * tile + (i % tile) * tile + (j % tile);
+}
+
+
+// Smallest power of 2 that is at least n, and largest that is at most n
+inline int power_of_2_above(int n) {
+
+    int power = 1;
+    while (power < n)
+        power *= 2;
+    return power;
+}
+
+inline int power_of_2_below(int n) {
+
+    int power = 1;
+    while (2 * power <= n)
+        power *= 2;
+    return power;
+}
+
+// Conversion from row major. A tile of 32 x 32 keeps three tiles (the
+// working set of the base case) within a typical 32 KB L1 data cache
+// A tile that is not a power of 2 is rounded down to one
+template <typename T>
+MortonMatrix<T> to_morton(const matrix<T> & a, int tile = 32) {
+
+    int size = a.size();
+    int padded = power_of_2_above(size);
+    tile = std::min(power_of_2_below(std::max(tile, 1)), padded);
+
+    MortonMatrix<T> m{size, padded, tile, std::vector<T>(std::size_t(padded) * padded, T{})};
+
+    for (int i = 0; i < size; ++i)
+        for (int j = 0; j < size; ++j)
+            m.elements[morton_offset(i, j, tile)] = a[i][j];
+
+    return m;
+}
+
+// Conversion back to row major, without the padding
+template <typename T>
+matrix<T> from_morton(const MortonMatrix<T> & m) {
+
+    matrix<T> a(m.size, std::vector<T>(m.size));
+
+    for (int i = 0; i < m.size; ++i)
+        for (int j = 0; j < m.size; ++j)
+            a[i][j] = m.elements[morton_offset(i, j, m.tile)];
+
+    return a;
+}
+
+
+// c += a * b, where a, b and c each point to one contiguous 'size' x 'size'
+// block in Morton layout. The products are accumulated straight into c,
+// so unlike the version above, no temporary matrices are created
+template <typename T>
+void morton_multiply_add(const T * a, const T * b, T * c, int size, int tile) {
+
+    // Base case: row major tiles, in i-k-j order for unit stride access
+    if (size == tile) {
+        for (int i = 0; i < tile; ++i)
+            for (int k = 0; k < tile; ++k) {
+                T a_ik = a[i * tile + k];
+                for (int j = 0; j < tile; ++j)
+                    c[i * tile + j] += a_ik * b[k * tile + j];
+            }
+        return;
+    }
+
+    // Quadrants 0-3 are top-left, top-right, bottom-left, bottom-right
+    int half = size / 2;
+    std::size_t quadrant = std::size_t(half) * half;
+
+    const T * a00 = a, * a01 = a + quadrant, * a10 = a + 2 * quadrant, * a11 = a + 3 * quadrant;
+    const T * b00 = b, * b01 = b + quadrant, * b10 = b + 2 * quadrant, * b11 = b + 3 * quadrant;
+    T * c00 = c, * c01 = c + quadrant, * c10 = c + 2 * quadrant, * c11 = c + 3 * quadrant;
+
+    morton_multiply_add(a00, b00, c00, half, tile);
+    morton_multiply_add(a01, b10, c00, half, tile);
+
+    morton_multiply_add(a00, b01, c01, half, tile);
+    morton_multiply_add(a01, b11, c01, half, tile);
+
+    morton_multiply_add(a10, b00, c10, half, tile);
+    morton_multiply_add(a11, b10, c10, half, tile);
+
+    morton_multiply_add(a10, b01, c11, half, tile);
+    morton_multiply_add(a11, b11, c11, half, tile);
+}
+
+
+// Matrix multiplication algorithm on Morton layout matrices
+template <typename T>
+MortonMatrix<T> square_matrix_multiply_morton(const MortonMatrix<T> & a, const MortonMatrix<T> & b) {
+
+    MortonMatrix<T> c{a.size, a.padded, a.tile, std::vector<T>(a.elements.size(), T{})};
+    morton_multiply_add(a.elements.data(), b.elements.data(), c.elements.data(), a.padded, a.tile);
+    return c;
+}
+
+// Convenience overload for row major input and output
+template <typename T>
+matrix<T> square_matrix_multiply_morton(const matrix<T> & a, const matrix<T> & b) {
+    return from_morton(square_matrix_multiply_morton(to_morton(a), to_morton(b)));
+}
+
 
 // Demonstration
 int main(int argc, char * argv[]) {
@@ -116,4 +267,9 @@ int main(int argc, char * argv[]) {
     
     auto multiplied = square_matrix_multiply_recursive(a, b, 0, 0, 0, 0, a.size());
     print_matrix(multiplied);
+
+    std::cout << "Result of multiplying in Morton layout (2 x 2 tiles)...\n";
+
+    auto morton = square_matrix_multiply_morton(to_morton(a, 2), to_morton(b, 2));
+    print_matrix(from_morton(morton));
 }
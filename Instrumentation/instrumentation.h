@@ -0,0 +1,237 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Instrumentation Policies
+//  Comparison, swap, move and allocation hooks for the sorting and heap
+//  algorithms, with optional hardware counter sampling (Linux perf_event)
+//
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// Instrumented algorithms take the policy as their first template
+// parameter, for example quicksort<count_operations>(list, 0, n - 1).
+// Every policy provides the same static hooks:
+//
+//   compare(bool)   - called with the result of each key comparison
+//   swap(a, b)      - exchanges two elements
+//   move(n)         - records n element copies/moves
+//   allocate(bytes) - records one temporary allocation
+//   scope{name}     - RAII guard placed around each call of an algorithm
+
+
+// The default policy. Every hook is an empty inline function, so an
+// uninstrumented algorithm compiles to exactly the same code as before
+struct no_instrumentation {
+
+    static bool compare(bool result) { return result; }
+
+    template <typename T>
+    static void swap(T & a, T & b) { std::swap(a, b); }
+
+    static void move(std::size_t) {}
+    static void allocate(std::size_t) {}
+
+    struct scope {
+        scope(const char *) {}
+    };
+};
+
+
+
+// Totals gathered by count_operations
+struct operation_counts {
+    std::uint64_t comparisons = 0;
+    std::uint64_t swaps = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+};
+
+// Counts comparisons, swaps, moves and allocations (per thread)
+struct count_operations {
+
+    static operation_counts & counts() {
+        thread_local operation_counts totals;
+        return totals;
+    }
+
+    static void reset() { counts() = operation_counts{}; }
+
+    static bool compare(bool result) {
+        ++counts().comparisons;
+        return result;
+    }
+
+    template <typename T>
+    static void swap(T & a, T & b) {
+        ++counts().swaps;
+        std::swap(a, b);
+    }
+
+    static void move(std::size_t n) { counts().moves += n; }
+
+    static void allocate(std::size_t bytes) {
+        ++counts().allocations;
+        counts().allocated_bytes += bytes;
+    }
+
+    struct scope {
+        scope(const char *) {}
+    };
+};
+
+
+
+// Hardware counter readings accumulated over every call of one algorithm
+struct hardware_sample {
+    std::uint64_t calls = 0;
+    std::uint64_t cycles = 0;
+    std::uint64_t branch_misses = 0;
+    std::uint64_t cache_misses = 0;
+};
+
+#ifdef __linux__
+
+// A group of three perf_event counters (cycles, branch misses and last
+// level cache misses) for the calling thread. If the kernel refuses to
+// open them (no PMU, or perf_event_paranoid is too strict), available()
+// is false and every reading is zero
+class hardware_counters {
+
+    private:
+        static const int count = 3;
+        int fds[count];
+
+        static int open_counter(std::uint32_t type, std::uint64_t config, int group) {
+
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = group == -1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+        }
+
+        std::uint64_t read_counter(int index) {
+            std::uint64_t value = 0;
+            if (fds[index] == -1 || ::read(fds[index], &value, sizeof(value)) != sizeof(value))
+                return 0;
+            return value;
+        }
+
+    public:
+        hardware_counters() {
+            fds[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+            fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, fds[0]);
+            fds[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+        }
+
+        ~hardware_counters() {
+            for (int fd: fds)
+                if (fd != -1)
+                    close(fd);
+        }
+
+        hardware_counters(hardware_counters const &) = delete;
+        hardware_counters & operator=(hardware_counters const &) = delete;
+
+        bool available() const { return fds[0] != -1; }
+
+        void start() {
+            if (!available())
+                return;
+            ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+
+        void stop(hardware_sample & sample) {
+            if (!available())
+                return;
+            ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            sample.cycles += read_counter(0);
+            sample.branch_misses += read_counter(1);
+            sample.cache_misses += read_counter(2);
+        }
+};
+
+#else
+
+// Hardware counters are only implemented on Linux
+class hardware_counters {
+    public:
+        bool available() const { return false; }
+        void start() {}
+        void stop(hardware_sample &) {}
+};
+
+#endif
+
+
+// Counts operations like count_operations, and also samples hardware
+// counters around the outermost call of each instrumented algorithm.
+// Recursive calls (e.g. max_heapify) are folded into their outermost call
+struct sample_hardware : count_operations {
+
+    static hardware_counters & counters() {
+        thread_local hardware_counters group;
+        return group;
+    }
+
+    static std::map<std::string, hardware_sample> & samples() {
+        thread_local std::map<std::string, hardware_sample> totals;
+        return totals;
+    }
+
+    static void reset() {
+        count_operations::reset();
+        samples().clear();
+    }
+
+    struct scope {
+
+        const char * name;
+        bool outermost;
+
+        static int & depth() {
+            thread_local int nesting = 0;
+            return nesting;
+        }
+
+        scope(const char * name) : name{name}, outermost{depth()++ == 0} {
+            if (outermost)
+                counters().start();
+        }
+
+        ~scope() {
+            --depth();
+            if (outermost) {
+                auto & sample = samples()[name];
+                counters().stop(sample);
+                ++sample.calls;
+            }
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,35 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Thread Count Policy
+//  How many threads the parallel algorithms start for a given amount of work
+//
+
+#ifndef THREAD_COUNT_H
+#define THREAD_COUNT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+
+
+// Threads to use for 'work' units split over at most 'pieces' independent
+// ranges, where each thread should get at least 'min_work_per_thread'
+// units. Below that, starting a thread costs more than it saves, so small
+// inputs stay on the caller's thread; the hardware thread count is only
+// looked up (a system call) once the work is large enough to use it.
+// 'threads' of 0 uses every hardware thread
+inline unsigned thread_count(std::size_t work, std::size_t min_work_per_thread,
+        unsigned threads = 0, std::size_t pieces = std::size_t(-1)) {
+
+    if (work < 2 * min_work_per_thread || pieces < 2)
+        return 1;
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    return std::min<std::size_t>({threads, pieces, work / min_work_per_thread});
+}
+
+#endif
@@ -26,7 +26,7 @@ void bucket_sort(std::vector<T> & list) {
 
     int n = list.size();
 
-    std::vector<T> buckets[n];
+    std::vector<std::vector<T>> buckets(n);
 
 
     // Distribute numbers into different buckets
@@ -39,7 +39,7 @@ void counting_sort(std::vector<int> & array) {
 
     // Assign the contents back into the original array
     // Counting sort must use second array, it doesn't work 'in place'
-    for (int i = 0; i <= (int)array.size(); ++i)
+    for (int i = 0; i < (int)array.size(); ++i)
         array[i] = sorted[i];
 }
 
@@ -0,0 +1,165 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Indirect Sort (argsort) with key prefixes
+//  Worst case time complexity: O(n log(n)) comparisons, O(n) record moves
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+
+//  Sorting large records by swapping them spends most of its time moving
+//  memory. Instead, sort a compact array of (key prefix, index) entries,
+//  then either hand back the permutation or apply it to the records once.
+//
+//  A key prefix is a fixed width integer that preserves the key order:
+//  if prefix(a) < prefix(b) then a < b. Entries are ordered by prefix
+//  alone, and the full keys are only compared when two prefixes are equal.
+
+
+// One entry per record: 16 bytes, so four fit in a cache line
+struct sort_entry {
+    std::uint64_t prefix;
+    std::size_t index;
+};
+
+
+// Order preserving prefix for integral keys (signed keys have their sign
+// bit flipped, so negative numbers sort before positive ones)
+struct integer_prefix {
+    template <typename T>
+    std::uint64_t operator()(const T & key) const {
+        static_assert(std::is_integral<T>::value, "integer_prefix needs an integral key");
+
+        std::uint64_t bits = key;
+        if (std::is_signed<T>::value)
+            bits ^= std::uint64_t{1} << 63;
+        return bits;
+    }
+};
+
+// Order preserving prefix for strings: the first 8 bytes, big endian
+struct string_prefix {
+    std::uint64_t operator()(const std::string & key) const {
+
+        std::uint64_t bits = 0;
+        for (std::size_t i = 0; i < 8; ++i) {
+            unsigned char c = i < key.size() ? key[i] : 0;
+            bits = (bits << 8) | c;
+        }
+        return bits;
+    }
+};
+
+
+//  Argsort - return the permutation that sorts 'list', i.e. list[order[0]]
+//  is the smallest record. 'key' extracts the sort key from a record,
+//  'prefix' maps a key to its prefix, and ties are broken on the full key
+//  and then on the original position, so the sort is stable
+
+template <typename T, typename Key, typename Prefix>
+std::vector<std::size_t> argsort(const std::vector<T> & list, Key key, Prefix prefix) {
+
+    std::vector<sort_entry> entries(list.size());
+    for (std::size_t i = 0; i < list.size(); ++i)
+        entries[i] = {prefix(key(list[i])), i};
+
+    std::sort(entries.begin(), entries.end(),
+        [&](const sort_entry & a, const sort_entry & b) {
+
+            if (a.prefix != b.prefix)
+                return a.prefix < b.prefix;
+
+            // Prefixes match, so fall back to the full keys
+            const auto & key_a = key(list[a.index]);
+            const auto & key_b = key(list[b.index]);
+
+            if (key_a < key_b)  return true;
+            if (key_b < key_a)  return false;
+            return a.index < b.index;
+        });
+
+    std::vector<std::size_t> order(list.size());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+        order[i] = entries[i].index;
+
+    return order;
+}
+
+
+//  Rearrange 'list' in place so that the new list[i] is the old
+//  list[order[i]]. Each cycle of the permutation is followed once, holding
+//  a single record aside, so every record moves exactly once (plus one
+//  extra move per cycle) and no second copy of the list is needed
+
+template <typename T>
+void apply_permutation(std::vector<T> & list, const std::vector<std::size_t> & order) {
+
+    std::vector<bool> placed(list.size(), false);
+
+    for (std::size_t start = 0; start < list.size(); ++start) {
+
+        if (placed[start])
+            continue;
+
+        // Walk the cycle through 'start', pulling each record into place
+        T held = std::move(list[start]);
+        std::size_t current = start;
+
+        while (order[current] != start) {
+            list[current] = std::move(list[order[current]]);
+            placed[current] = true;
+            current = order[current];
+        }
+
+        list[current] = std::move(held);
+        placed[current] = true;
+    }
+}
+
+
+//  Indirect Sort - stable sort of 'list' by key, moving each record once
+template <typename T, typename Key, typename Prefix>
+void indirect_sort(std::vector<T> & list, Key key, Prefix prefix) {
+    apply_permutation(list, argsort(list, key, prefix));
+}
+
+
+// Demonstration
+struct record {
+    std::string name;
+    int id;
+    char payload[160];
+};
+
+int main(int argc, char * argv[]) {
+
+    std::vector<record> records{
+        {"mercury", 4, {}}, {"venus", 2, {}}, {"earth", 7, {}},
+        {"mars", 1, {}}, {"jupiter", 9, {}}, {"saturn", 3, {}}};
+
+    auto by_name = [](const record & r) -> const std::string & { return r.name; };
+    auto by_id = [](const record & r) { return r.id; };
+
+    // Only the permutation is computed; the records do not move
+    auto order = argsort(records, by_id, integer_prefix{});
+
+    std::cout << "Records in order of id...\n\t";
+    for (auto index: order)
+        std::cout << records[index].id << ':' << records[index].name << ", ";
+    std::cout << std::endl;
+
+    // Sort the records themselves by name
+    indirect_sort(records, by_name, string_prefix{});
+
+    std::cout << "Records after sorting by name...\n\t";
+    for (auto & r: records)
+        std::cout << r.name << ", ";
+    std::cout << std::endl;
+}
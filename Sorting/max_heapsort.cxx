@@ -13,6 +13,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "../Instrumentation/instrumentation.h"
+
 // A custom C++ Heap class
 template <typename T>
 class Heap {
@@ -56,57 +58,60 @@ class Heap {
 
 // Heapify w/ max heap (pg. 154) - O(log n)
 // If needed, make heap[index] 'float down' to satisfy ordering property
-template <typename T>
+// Comparisons and swaps are reported to the 'Instrument' policy
+template <typename Instrument = no_instrumentation, typename T>
 void max_heapify(Heap<T> & heap, int index) {
 
+    typename Instrument::scope sample{"max_heapify"};
+
     int largest;
 
     int left = heap.left(index);
     int right = heap.right(index);
 
-    if (left < heap.heap_size && heap[left] > heap[index])
+    if (left < heap.heap_size && Instrument::compare(heap[left] > heap[index]))
         largest = left;
     else
         largest = index;
 
-    if (right < heap.heap_size && heap[right] > heap[largest])
+    if (right < heap.heap_size && Instrument::compare(heap[right] > heap[largest]))
         largest = right;
 
     if (largest != index) {
-        std::swap(heap[index], heap[largest]);
+        Instrument::swap(heap[index], heap[largest]);
 
-        max_heapify(heap, largest);
+        max_heapify<Instrument>(heap, largest);
     }
 }
 
 
 // Build Heap w/ max heap (pg. 157) - O(n)
 // Heapify all non-leaf nodes to make them sink to appropriate spot
-template <typename T>
+template <typename Instrument = no_instrumentation, typename T>
 void build_max_heap(Heap<T> & heap) {
 
     heap.heap_size = heap.length;
     for (int index = ((heap.length - 1) / 2); index >= 0; --index)
-        max_heapify(heap, index);
+        max_heapify<Instrument>(heap, index);
 }
 
 
 // Heapsort for max heaps (pg. 160) - O(n log n)
 // Make a max heap, then swap from bottom up to arrange in sorted order
-template <typename T>
+template <typename Instrument = no_instrumentation, typename T>
 void max_heapsort(Heap<T> & heap) {
 
-    build_max_heap(heap);
+    build_max_heap<Instrument>(heap);
 
     for (int index = heap.length - 1; index >= 1; --index) {
 
-        std::swap(heap[0], heap[index]);
+        Instrument::swap(heap[0], heap[index]);
         //T temp = heap[0];
         //heap[0] = heap[index];
         //heap[index] = temp;
 
         --heap.heap_size;
-        max_heapify(heap, 0);
+        max_heapify<Instrument>(heap, 0);
     }
 }
 
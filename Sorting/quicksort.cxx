@@ -6,6 +6,9 @@
 //  Worst case time complexity: O(n^2)
 //  Average case time complexity: O(n lgn) with small constants
 //
+//  Randomized Select (pg. 216), Select (pg. 220)
+//  Worst case time complexity: O(n) (introselect)
+//
 //  Implemented by Joel Rorseth
 //  Created on July 5, 2017
 //
@@ -13,22 +16,28 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <random>
+
+#include "../Instrumentation/instrumentation.h"
 
 
 //  Rearrange the array in place and determine a pivot index
-template <typename T>
+//  Comparisons and swaps are reported to the 'Instrument' policy
+template <typename Instrument = no_instrumentation, typename T>
 int partition(std::vector<T> & list, int start, int end) {
 
+	typename Instrument::scope sample{"partition"};
+
 	T x = list[end];
 	int i = start - 1;
 
 	for (int j = start; j < end; ++j)
-		if (list[j] <= x) {
+		if (Instrument::compare(list[j] <= x)) {
 			++i;
-			std::swap(list[i], list[j]);
+			Instrument::swap(list[i], list[j]);
 		}
 
-	std::swap(list[i + 1], list[end]);
+	Instrument::swap(list[i + 1], list[end]);
 	return i + 1;
 }
 
@@ -37,20 +46,253 @@ int partition(std::vector<T> & list, int start, int end) {
 //  such that: elements in A[p..q-1] <= A[q] <= elements in A[q+1..r]
 //  Recurse until sort is trivial (zero or one elements per partition)
 
-template <typename T>
+template <typename Instrument = no_instrumentation, typename T>
 void quicksort(std::vector<T> & list, int start, int end) {
 
 	if (start < end) {
 
 		// Calculate partition index aka the 'pivot'
-		int pivot = partition(list, start, end);
+		int pivot = partition<Instrument>(list, start, end);
 
 		// Recursively sort each half about the pivot
-		quicksort(list, start, pivot - 1);
-		quicksort(list, pivot + 1, end);
+		quicksort<Instrument>(list, start, pivot - 1);
+		quicksort<Instrument>(list, pivot + 1, end);
+	}
+}
+
+
+//  Selection (Chapter 9)
+//  Many callers only need the k-th smallest element, a few percentiles,
+//  or the k smallest elements in order. The routines below reuse
+//  partition() to do this in O(n) expected time instead of sorting.
+//  Ranks 'k' are absolute indexes into the list: on return, list[k] holds
+//  the element that would be there if the whole range were sorted.
+
+
+// Shared random engine for pivot selection
+inline std::mt19937 & pivot_generator() {
+	thread_local std::mt19937 generator{std::random_device{}()};
+	return generator;
+}
+
+
+//  Randomized Partition (pg. 179)
+//  Swap a random element into the pivot position before partitioning
+template <typename Instrument = no_instrumentation, typename T>
+int randomized_partition(std::vector<T> & list, int start, int end) {
+
+	std::uniform_int_distribution<int> pick(start, end);
+	Instrument::swap(list[end], list[pick(pivot_generator())]);
+
+	return partition<Instrument>(list, start, end);
+}
+
+
+//  After partition() places the pivot at list[q], keys equal to the pivot
+//  may still be scattered through list[start..q-1]. Gather them next to
+//  the pivot and return 'low', so that list[low..q] all equal the pivot.
+//  Without this, many duplicate keys degrade selection to O(n^2)
+template <typename Instrument = no_instrumentation, typename T>
+int gather_equal(std::vector<T> & list, int start, int q) {
+
+	int low = q;
+
+	// Everything left of q is <= pivot, so 'not less' means 'equal'
+	for (int j = q - 1; j >= start; --j)
+		if (!Instrument::compare(list[j] < list[q]))
+			Instrument::swap(list[j], list[--low]);
+
+	return low;
+}
+
+
+//  Randomized Select (pg. 216) - O(n) expected, O(n^2) worst case
+//  Iterative form of the book's tail recursion
+template <typename Instrument = no_instrumentation, typename T>
+T randomized_select(std::vector<T> & list, int start, int end, int k) {
+
+	while (start < end) {
+
+		int q = randomized_partition<Instrument>(list, start, end);
+		int low = gather_equal<Instrument>(list, start, q);
+
+		// Continue only in the side that contains rank k
+		if (k < low)
+			end = low - 1;
+		else if (k > q)
+			start = q + 1;
+		else
+			break;
+	}
+
+	return list[k];
+}
+
+
+template <typename Instrument = no_instrumentation, typename T>
+T median_of_medians_select(std::vector<T> & list, int start, int end, int k);
+
+//  Sort a group of at most 5 elements with insertion sort
+template <typename Instrument = no_instrumentation, typename T>
+void sort_group(std::vector<T> & list, int first, int last) {
+
+	for (int j = first + 1; j <= last; ++j)
+		for (int i = j; i > first && Instrument::compare(list[i] < list[i - 1]); --i)
+			Instrument::swap(list[i], list[i - 1]);
+}
+
+//  Median of medians pivot (pg. 220)
+//  Sort groups of 5, move each group's median to the front of the range,
+//  then recursively select the median of those medians. Returns its index
+template <typename Instrument = no_instrumentation, typename T>
+int median_of_medians(std::vector<T> & list, int start, int end) {
+
+	int medians = start;
+
+	for (int group = start; group <= end; group += 5) {
+
+		int last = std::min(group + 4, end);
+		sort_group<Instrument>(list, group, last);
+		Instrument::swap(list[medians++], list[group + (last - group) / 2]);
+	}
+
+	int mid = start + (medians - start - 1) / 2;
+	median_of_medians_select<Instrument>(list, start, medians - 1, mid);
+
+	return mid;
+}
+
+//  Select (pg. 220) - O(n) worst case
+//  Like randomized_select(), but the pivot is always the median of
+//  medians, which guarantees a constant fraction is discarded each pass
+template <typename Instrument, typename T>
+T median_of_medians_select(std::vector<T> & list, int start, int end, int k) {
+
+	while (start < end) {
+
+		if (end - start < 5) {
+			sort_group<Instrument>(list, start, end);
+			break;
+		}
+
+		int pivot = median_of_medians<Instrument>(list, start, end);
+		Instrument::swap(list[pivot], list[end]);
+
+		int q = partition<Instrument>(list, start, end);
+		int low = gather_equal<Instrument>(list, start, q);
+
+		if (k < low)
+			end = low - 1;
+		else if (k > q)
+			start = q + 1;
+		else
+			break;
+	}
+
+	return list[k];
+}
+
+
+//  Introselect - O(n) expected and worst case
+//  Run randomized_select(), but if the range has not halved after a
+//  few rounds (an unlucky or adversarial input), finish with the median
+//  of medians, whose constant factor is higher but whose bound is linear
+template <typename Instrument = no_instrumentation, typename T>
+T introselect(std::vector<T> & list, int start, int end, int k) {
+
+	int size = end - start + 1;
+	int rounds = 0;
+
+	while (start < end) {
+
+		// Allow two rounds per halving before giving up on random pivots
+		if (++rounds > 2) {
+			if (2 * (end - start + 1) > size)
+				return median_of_medians_select<Instrument>(list, start, end, k);
+
+			size = end - start + 1;
+			rounds = 1;
+		}
+
+		int q = randomized_partition<Instrument>(list, start, end);
+		int low = gather_equal<Instrument>(list, start, q);
+
+		if (k < low)
+			end = low - 1;
+		else if (k > q)
+			start = q + 1;
+		else
+			break;
+	}
+
+	return list[k];
+}
+
+
+//  Partial Sort - O(n + k log k) expected
+//  Sort only the k smallest elements into list[start..start+k-1]. This
+//  is quicksort that skips every partition lying entirely beyond rank k
+template <typename Instrument = no_instrumentation, typename T>
+void partial_sort(std::vector<T> & list, int start, int end, int k) {
+
+	int last = start + k - 1;
+
+	while (start < end && start <= last) {
+
+		int q = randomized_partition<Instrument>(list, start, end);
+		int low = gather_equal<Instrument>(list, start, q);
+
+		// The left side is always needed; recurse into it and loop on
+		// the right side only while it still overlaps the first k ranks
+		partial_sort<Instrument>(list, start, low - 1, last - start + 1);
+		start = q + 1;
+	}
+}
+
+template <typename Instrument = no_instrumentation, typename T>
+void partial_sort(std::vector<T> & list, int k) {
+	partial_sort<Instrument>(list, 0, list.size() - 1, k);
+}
+
+
+//  Multi-Select - O(n log m) for m ranks, O(n) for a fixed handful
+//  Select several ranks (e.g. p50/p90/p99) in one recursive pass. Each
+//  partition splits the sorted ranks, and only sides holding a rank are
+//  visited, so the partitions near the top of the recursion are shared
+template <typename Instrument = no_instrumentation, typename T>
+void multi_select(std::vector<T> & list, int start, int end,
+		std::vector<int>::const_iterator first, std::vector<int>::const_iterator last) {
+
+	while (first != last && start < end) {
+
+		int q = randomized_partition<Instrument>(list, start, end);
+		int low = gather_equal<Instrument>(list, start, q);
+
+		// Ranks in [low, q] are already in place
+		auto left = std::lower_bound(first, last, low);
+		auto right = std::upper_bound(left, last, q);
+
+		multi_select<Instrument>(list, start, low - 1, first, left);
+		start = q + 1;
+		first = right;
 	}
 }
 
+// Returns list[k] for each rank in 'ranks', in the order given
+template <typename Instrument = no_instrumentation, typename T>
+std::vector<T> multi_select(std::vector<T> & list, std::vector<int> const & ranks) {
+
+	std::vector<int> sorted_ranks{ranks};
+	std::sort(sorted_ranks.begin(), sorted_ranks.end());
+
+	multi_select<Instrument>(list, 0, list.size() - 1, sorted_ranks.cbegin(), sorted_ranks.cend());
+
+	std::vector<T> selected;
+	for (int k: ranks)
+		selected.push_back(list[k]);
+	return selected;
+}
+
 
 // Demonstration
 int main(int argc, char * argv[]) {
@@ -72,4 +314,26 @@ int main(int argc, char * argv[]) {
     for (auto num: a)
         std::cout << num << ", ";
     std::cout << "}" << std::endl;
+
+    // Selection only places the requested ranks, without a full sort
+    std::vector<int> b{41,7,93,18,64,2,77,35,50,26,88,12,59,3,70};
+
+    auto median = introselect(b, 0, b.size() - 1, b.size() / 2);
+    std::cout << "\nMedian of b is " << median << std::endl;
+
+    // Percentile ranks for p50, p90 and p99, selected in a single pass
+    std::vector<int> ranks;
+    for (double p: {0.50, 0.90, 0.99})
+        ranks.push_back(p * (b.size() - 1));
+
+    auto percentiles = multi_select(b, ranks);
+    std::cout << "p50, p90, p99 of b are " << percentiles[0] << ", "
+        << percentiles[1] << ", " << percentiles[2] << std::endl;
+
+    // Sort only the 5 smallest elements
+    partial_sort(b, 5);
+    std::cout << "After partial sort of 5 smallest...\n\tstd::vector b = { ";
+    for (auto num: b)
+        std::cout << num << ", ";
+    std::cout << "}" << std::endl;
 }
@@ -0,0 +1,278 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Segmented Sort (many small independent groups in one call)
+//  Worst case time complexity: O(n) per segment of n integer keys (radix),
+//  O(n^2) per segment of other keys up to 64 elements, O(n log(n)) above
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+#include "../Instrumentation/thread_count.h"
+
+
+//  Sorting millions of small groups one std::vector at a time pays for an
+//  allocation, a call and a cold start per group. Instead, keep every
+//  group in one flat buffer, described by offsets in the same way as the
+//  rows of a CSR matrix: segment s is data[offsets[s] .. offsets[s + 1]).
+//  Each segment is sorted in place, by the method that suits its size:
+//
+//      up to 8 elements     a sorting network (fixed, branch free)
+//      up to 64 elements    insertion sort
+//      larger segments      LSD radix sort for integral keys, std::sort otherwise
+//
+//  Radix sort needs a scratch buffer; each thread allocates one, sized for
+//  the largest segment, and reuses it for every segment it sorts.
+//  Sorting networks are not stable, so neither is segmented_sort.
+
+
+// Segments up to these sizes use a sorting network, then insertion sort
+const std::size_t network_limit = 8;
+const std::size_t insertion_limit = 64;
+
+
+// Put a pair of elements in order. std::min and std::max compile to
+// conditional moves, so a network of these has no branches to mispredict
+template <typename T>
+inline void compare_exchange(T * list, int i, int j) {
+
+    T a = list[i], b = list[j];
+    list[i] = std::min(a, b);
+    list[j] = std::max(a, b);
+}
+
+// Sorting networks for 2 to 8 elements, with the fewest known comparators
+// Each line is one layer of comparators that touch disjoint elements
+template <typename T>
+void sorting_network(T * list, std::size_t n) {
+
+    switch (n) {
+        case 2:
+            compare_exchange(list, 0, 1);
+            break;
+        case 3:
+            compare_exchange(list, 0, 2);
+            compare_exchange(list, 0, 1);
+            compare_exchange(list, 1, 2);
+            break;
+        case 4:
+            compare_exchange(list, 0, 2); compare_exchange(list, 1, 3);
+            compare_exchange(list, 0, 1); compare_exchange(list, 2, 3);
+            compare_exchange(list, 1, 2);
+            break;
+        case 5:
+            compare_exchange(list, 0, 3); compare_exchange(list, 1, 4);
+            compare_exchange(list, 0, 2); compare_exchange(list, 1, 3);
+            compare_exchange(list, 0, 1); compare_exchange(list, 2, 4);
+            compare_exchange(list, 1, 2); compare_exchange(list, 3, 4);
+            compare_exchange(list, 2, 3);
+            break;
+        case 6:
+            compare_exchange(list, 0, 5); compare_exchange(list, 1, 3); compare_exchange(list, 2, 4);
+            compare_exchange(list, 1, 2); compare_exchange(list, 3, 4);
+            compare_exchange(list, 0, 3); compare_exchange(list, 2, 5);
+            compare_exchange(list, 0, 1); compare_exchange(list, 2, 3); compare_exchange(list, 4, 5);
+            compare_exchange(list, 1, 2); compare_exchange(list, 3, 4);
+            break;
+        case 7:
+            compare_exchange(list, 0, 6); compare_exchange(list, 2, 3); compare_exchange(list, 4, 5);
+            compare_exchange(list, 0, 2); compare_exchange(list, 1, 4); compare_exchange(list, 3, 6);
+            compare_exchange(list, 0, 1); compare_exchange(list, 2, 5); compare_exchange(list, 3, 4);
+            compare_exchange(list, 1, 2); compare_exchange(list, 4, 6);
+            compare_exchange(list, 2, 3); compare_exchange(list, 4, 5);
+            compare_exchange(list, 1, 2); compare_exchange(list, 3, 4); compare_exchange(list, 5, 6);
+            break;
+        case 8:
+            compare_exchange(list, 0, 2); compare_exchange(list, 1, 3);
+            compare_exchange(list, 4, 6); compare_exchange(list, 5, 7);
+            compare_exchange(list, 0, 4); compare_exchange(list, 1, 5);
+            compare_exchange(list, 2, 6); compare_exchange(list, 3, 7);
+            compare_exchange(list, 0, 1); compare_exchange(list, 2, 3);
+            compare_exchange(list, 4, 5); compare_exchange(list, 6, 7);
+            compare_exchange(list, 2, 4); compare_exchange(list, 3, 5);
+            compare_exchange(list, 1, 4); compare_exchange(list, 3, 6);
+            compare_exchange(list, 1, 2); compare_exchange(list, 3, 4); compare_exchange(list, 5, 6);
+            break;
+    }
+}
+
+
+// Insertion sort (pg. 18) of list[0 .. n)
+template <typename T>
+void insertion_sort(T * list, std::size_t n) {
+
+    for (std::size_t j = 1; j < n; ++j) {
+
+        T key = list[j];
+        std::size_t i = j;
+
+        while (i > 0 && list[i - 1] > key) {
+            list[i] = list[i - 1];
+            --i;
+        }
+        list[i] = key;
+    }
+}
+
+
+// LSD radix sort (pg. 198) of list[0 .. n) on 8 bit digits, using
+// 'scratch' (room for n elements) as the second buffer
+// Keys are taken relative to the smallest key, so only the digits that
+// vary within the segment are sorted; small ranges need one or two passes
+template <typename T>
+void radix_sort(T * list, std::size_t n, T * scratch) {
+
+    using key_type = typename std::make_unsigned<T>::type;
+
+    auto bounds = std::minmax_element(list, list + n);
+    key_type low = *bounds.first;
+    key_type range = key_type(*bounds.second) - low;
+
+    T * from = list;
+    T * to = scratch;
+
+    for (unsigned shift = 0; shift < sizeof(T) * 8 && (range >> shift) != 0; shift += 8) {
+
+        std::size_t count[257] = {};
+
+        for (std::size_t i = 0; i < n; ++i)
+            ++count[((key_type(from[i]) - low) >> shift & 0xff) + 1];
+        for (int digit = 0; digit < 256; ++digit)
+            count[digit + 1] += count[digit];
+
+        for (std::size_t i = 0; i < n; ++i)
+            to[count[(key_type(from[i]) - low) >> shift & 0xff]++] = from[i];
+
+        std::swap(from, to);
+    }
+
+    // After an odd number of passes, the result is in the scratch buffer
+    if (from != list)
+        std::copy(from, from + n, list);
+}
+
+
+// Sort one segment in place, choosing the method by its size
+template <typename T>
+void sort_segment(T * list, std::size_t n, std::vector<T> & scratch) {
+
+    if (n <= network_limit)
+        sorting_network(list, n);
+    else if (n <= insertion_limit)
+        insertion_sort(list, n);
+    else if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value)
+        radix_sort(list, n, scratch.data());
+    else
+        std::sort(list, list + n);
+}
+
+
+//  Segmented sort algorithm: sort each data[offsets[s] .. offsets[s + 1])
+//
+//  Segment sizes are often skewed, so handing each thread an equal share
+//  of segments up front can leave one thread with all the large ones.
+//  Instead, segments are handed out in small chunks from a shared atomic
+//  cursor; a thread that finishes early simply takes the next chunk, so
+//  no thread idles while work remains. 'threads' of 0 uses every hardware
+//  thread; small inputs run on the caller's thread.
+
+template <typename T>
+void segmented_sort(std::vector<T> & data, std::vector<std::size_t> const & offsets,
+        unsigned threads = 0) {
+
+    if (offsets.size() < 2)
+        return;
+
+    std::size_t segments = offsets.size() - 1;
+
+    std::size_t largest = 0;
+    for (std::size_t s = 0; s < segments; ++s)
+        largest = std::max(largest, offsets[s + 1] - offsets[s]);
+    std::size_t scratch_size = largest > insertion_limit ? largest : 0;
+
+    // Each thread sorts at least this many elements
+    const std::size_t min_elements_per_thread = 1 << 15;
+    std::size_t elements = offsets[segments] - offsets[0];
+    threads = thread_count(elements, min_elements_per_thread, threads, segments);
+
+    // Several chunks per thread, so the last chunks to finish are small
+    std::size_t chunk = std::max<std::size_t>(1, segments / (threads * 64));
+    std::atomic<std::size_t> cursor{0};
+
+    auto work = [&]() {
+        std::vector<T> scratch(scratch_size);
+
+        for (;;) {
+            std::size_t first = cursor.fetch_add(chunk, std::memory_order_relaxed);
+            if (first >= segments)
+                return;
+
+            std::size_t last = std::min(segments, first + chunk);
+            for (std::size_t s = first; s < last; ++s)
+                sort_segment(data.data() + offsets[s], offsets[s + 1] - offsets[s], scratch);
+        }
+    };
+
+    if (threads == 1) {
+        work();
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t)
+        workers.emplace_back(work);
+
+    for (auto & worker: workers)
+        worker.join();
+}
+
+
+// Boolean keys: std::vector<bool> packs them into bits, so there are no
+// elements to point into. Each segment is sorted by counting its false
+// keys, which takes O(n) time per segment, on the caller's thread (bits
+// shared between neighbouring segments cannot be written in parallel)
+inline void segmented_sort(std::vector<bool> & data, std::vector<std::size_t> const & offsets,
+        unsigned /* threads */ = 0) {
+
+    for (std::size_t s = 0; s + 1 < offsets.size(); ++s) {
+        auto first = data.begin() + offsets[s], last = data.begin() + offsets[s + 1];
+        auto falses = std::count(first, last, false);
+        std::fill(first, first + falses, false);
+        std::fill(first + falses, last, true);
+    }
+}
+
+
+// Demonstration
+int main(int argc, char * argv[]) {
+
+    // Three groups of events, one after another in a single buffer
+    std::vector<int> data{5,3,9,1,  42,17,8,23,4,16,15,99,0,7,  -3,12,-8,6};
+    std::vector<std::size_t> offsets{0, 4, 14, 18};
+
+    // Print each segment before and after sorting
+    std::cout << "Before sorting...\n";
+    for (std::size_t s = 0; s + 1 < offsets.size(); ++s) {
+        std::cout << "\tsegment " << s << " = { ";
+        for (auto i = offsets[s]; i < offsets[s + 1]; ++i)
+            std::cout << data[i] << ", ";
+        std::cout << "}\n";
+    }
+
+    segmented_sort(data, offsets);
+
+    std::cout << "After sorting...\n";
+    for (std::size_t s = 0; s + 1 < offsets.size(); ++s) {
+        std::cout << "\tsegment " << s << " = { ";
+        for (auto i = offsets[s]; i < offsets[s + 1]; ++i)
+            std::cout << data[i] << ", ";
+        std::cout << "}\n";
+    }
+}
@@ -0,0 +1,490 @@
+//
+//  Introduction to Algorithms (Third Edition)
+//  Cormen, Leiserson, Rivest, Stein
+//
+//  Input Aware Sort (a front end to the sorting algorithms in this repository)
+//  Worst case time complexity: O(n log(n)), O(n + k) for keys in a range k
+//
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "../Instrumentation/instrumentation.h"
+
+
+//  Each sorting algorithm in the repository wins on some inputs and loses
+//  badly on others: counting sort is linear but only for a small key
+//  range, adaptive merge sort is linear on presorted input, insertion
+//  sort is fastest for a handful of keys, and quicksort is quadratic on
+//  exactly the inputs that adaptive merge sort likes. sort() looks at the
+//  input first, in one pass plus a small random sample, then hands it to
+//  the algorithm expected to be fastest.
+//
+//  The algorithms are included from their own files, each in a private
+//  namespace with its demonstration main() renamed, as in the benchmark
+//  harness. The headers they need are included above, outside of those
+//  namespaces.
+
+#pragma push_macro("main")
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main demo
+
+namespace insertion {
+#include "../Basic Algorithms/insertion_sort.cxx"
+}
+
+namespace merging {
+#include "../Divide and Conquer/merge_sort.cxx"
+}
+
+namespace quick {
+#include "quicksort.cxx"
+}
+
+namespace heapsort {
+#include "max_heapsort.cxx"
+}
+
+namespace counting {
+#include "counting_sort.cxx"
+}
+
+namespace bucket {
+#include "bucket_sort.cxx"
+}
+
+#pragma GCC diagnostic pop
+#pragma pop_macro("main")
+
+
+
+// The algorithms sort() can choose from
+enum class sort_engine { none, insertion, counting, adaptive_merge, bucket, introsort };
+
+inline std::string engine_name(sort_engine engine) {
+
+    switch (engine) {
+        case sort_engine::none: return "none (already sorted)";
+        case sort_engine::insertion: return "insertion sort";
+        case sort_engine::counting: return "counting sort";
+        case sort_engine::adaptive_merge: return "adaptive merge sort";
+        case sort_engine::bucket: return "bucket sort";
+        case sort_engine::introsort: return "introsort (quicksort, heapsort fallback)";
+    }
+    return "";
+}
+
+
+// Decision thresholds. The defaults are what calibrate_sort() measured on
+// an x86-64 development machine; call it to measure them on the host
+struct sort_thresholds {
+
+    // Inputs up to this size use insertion sort
+    int insertion_limit = 128;
+
+    // Integer keys use counting sort when their range is at most this
+    // many times the number of keys
+    double counting_range = 16;
+
+    // Adaptive merge sort is used when there are at least this many keys
+    // per run (ascending or descending, as merge_sort.cxx finds them), or
+    // this many when counting sort would otherwise be used
+    double presorted_ratio = 4;
+    double presorted_counting_ratio = 32;
+
+    // Bucket sort is used for uniform floating point keys in [0, 1)
+    bool bucket_uniform = false;
+};
+
+// The thresholds sort() uses by default; calibrate_sort() replaces them
+inline sort_thresholds & sort_tuning() {
+    static sort_thresholds thresholds;
+    return thresholds;
+}
+
+
+// What one pass over the input (and a sample of 'sample_size' keys) shows
+template <typename T>
+struct input_profile {
+    std::size_t n = 0;
+    T min{}, max{};
+    std::size_t descents = 0;       // i such that list[i + 1] < list[i]
+    std::size_t runs = 1;           // maximal ascending or descending runs
+    double distinct = 1;            // fraction of distinct keys in the sample
+    bool uniform = false;           // sample spread evenly over [min, max]
+};
+
+const std::size_t sample_size = 256;
+
+template <typename T>
+input_profile<T> profile_input(std::vector<T> const & list) {
+
+    input_profile<T> profile;
+    profile.n = list.size();
+    if (list.empty())
+        return profile;
+
+    // Range and sortedness take a single pass over the whole input. A new
+    // run starts at each strict peak or valley; runs across equal keys
+    // are not followed, so 'runs' is an estimate. Every quantity is an
+    // independent sum, min or max, so the loop has no branches to
+    // mispredict and can be vectorized
+    profile.min = std::min(list[0], list.back());
+    profile.max = std::max(list[0], list.back());
+    for (std::size_t i = 1; i + 1 < list.size(); ++i) {
+        bool down = list[i] < list[i - 1], up = list[i - 1] < list[i];
+        bool next_down = list[i + 1] < list[i], next_up = list[i] < list[i + 1];
+
+        profile.runs += (up & next_down) | (down & next_up);
+        profile.descents += down;
+        profile.min = std::min(profile.min, list[i]);
+        profile.max = std::max(profile.max, list[i]);
+    }
+    if (list.size() > 1)
+        profile.descents += list.back() < list[list.size() - 2];
+
+    // Duplicates and distribution are estimated from a random sample
+    std::mt19937_64 rng{list.size()};
+    std::vector<T> sample(std::min(sample_size, list.size()));
+    for (auto & key: sample)
+        key = list[rng() % list.size()];
+
+    // Uniform: every one of 8 equal width bins over [min, max] holds
+    // between half and twice its share of a full sample
+    if constexpr (std::is_arithmetic<T>::value)
+        if (sample.size() == sample_size && profile.min < profile.max) {
+            std::size_t bins[8] = {};
+            double width = double(profile.max) - double(profile.min);
+            for (auto key: sample)
+                ++bins[std::min(7, int((double(key) - double(profile.min)) / width * 8))];
+
+            profile.uniform = std::all_of(std::begin(bins), std::end(bins),
+                [](std::size_t count) { return count >= sample_size / 16 && count <= sample_size / 4; });
+        }
+
+    std::sort(sample.begin(), sample.end());
+    profile.distinct = double(std::unique(sample.begin(), sample.end()) - sample.begin()) / sample.size();
+
+    return profile;
+}
+
+
+// Choose the algorithm for an input with this profile
+template <typename T>
+sort_engine choose_engine(input_profile<T> const & profile, sort_thresholds const & thresholds) {
+
+    if (profile.descents == 0)
+        return sort_engine::none;
+
+    if (profile.n <= std::size_t(thresholds.insertion_limit))
+        return sort_engine::insertion;
+
+    if constexpr (std::is_integral<T>::value) {
+        double range = double(profile.max) - double(profile.min) + 1;
+        if (range <= thresholds.counting_range * profile.n && range < INT_MAX) {
+            if (profile.runs * thresholds.presorted_counting_ratio <= profile.n)
+                return sort_engine::adaptive_merge;
+            return sort_engine::counting;
+        }
+    }
+
+    if (profile.runs * thresholds.presorted_ratio <= profile.n)
+        return sort_engine::adaptive_merge;
+
+    if constexpr (std::is_floating_point<T>::value)
+        if (thresholds.bucket_uniform && profile.uniform && profile.min >= 0 && profile.max < 1)
+            return sort_engine::bucket;
+
+    return sort_engine::introsort;
+}
+
+
+
+// Introsort partitions up to this size are finished by insertion sort
+const int introsort_cutoff = 16;
+
+// Heapsort of list[start..end], through the Heap class of max_heapsort
+template <typename T>
+void heapsort_range(std::vector<T> & list, int start, int end) {
+
+    std::vector<T> keys(list.begin() + start, list.begin() + end + 1);
+    heapsort::Heap<T> heap{keys};
+    heapsort::max_heapsort(heap);
+
+    for (int i = start; i <= end; ++i)
+        list[i] = heap[i - start];
+}
+
+// Introsort: randomized quicksort (pg. 179) that switches to heapsort when
+// the recursion gets deeper than 'depth', so the worst case is O(n log(n)).
+// 'gather' keeps keys equal to the pivot together (see quicksort.cxx),
+// which only pays for itself when there are many duplicate keys
+template <typename T>
+void introsort(std::vector<T> & list, int start, int end, int depth, bool gather) {
+
+    // Recurse into the smaller side and loop on the larger, so the stack
+    // stays O(log n) deep
+    while (end - start + 1 > introsort_cutoff) {
+
+        if (depth-- == 0) {
+            heapsort_range(list, start, end);
+            return;
+        }
+
+        int q = quick::randomized_partition(list, start, end);
+        int low = gather ? quick::gather_equal(list, start, q) : q;
+
+        if (low - start < end - q) {
+            introsort(list, start, low - 1, depth, gather);
+            start = q + 1;
+        } else {
+            introsort(list, q + 1, end, depth, gather);
+            end = low - 1;
+        }
+    }
+
+    if (start < end)
+        merging::binary_insertion_sort(list, start, start, end);
+}
+
+template <typename T>
+void introsort(std::vector<T> & list, bool gather = false) {
+
+    int depth = 0;
+    for (auto n = list.size(); n > 1; n /= 2)
+        depth += 2;
+
+    introsort(list, 0, int(list.size()) - 1, depth, gather);
+}
+
+
+// Counting sort of integer keys, shifted so the smallest key is 0
+template <typename T>
+void counting_sort_shifted(std::vector<T> & list, T min) {
+
+    std::vector<int> keys(list.size());
+    for (std::size_t i = 0; i < list.size(); ++i)
+        keys[i] = int(list[i] - min);
+
+    counting::counting_sort(keys);
+
+    for (std::size_t i = 0; i < list.size(); ++i)
+        list[i] = T(keys[i] + min);
+}
+
+
+// Sort 'list' with the given algorithm
+template <typename T>
+void run_engine(std::vector<T> & list, sort_engine engine, input_profile<T> const & profile) {
+
+    switch (engine) {
+        case sort_engine::none:
+            break;
+        case sort_engine::insertion:
+            insertion::insertion_sort(list);
+            break;
+        case sort_engine::counting:
+            if constexpr (std::is_integral<T>::value)
+                counting_sort_shifted(list, profile.min);
+            break;
+        case sort_engine::adaptive_merge:
+            merging::adaptive_merge_sort(list, 0, int(list.size()) - 1);
+            break;
+        case sort_engine::bucket:
+            if constexpr (std::is_floating_point<T>::value)
+                bucket::bucket_sort(list);
+            break;
+        case sort_engine::introsort:
+            introsort(list, profile.distinct < 0.5);
+            break;
+    }
+}
+
+
+// Input aware sort: profile the input, then sort it with the algorithm
+// chosen for it. Returns the algorithm used
+template <typename T>
+sort_engine sort(std::vector<T> & list, sort_thresholds const & thresholds = sort_tuning()) {
+
+    auto profile = profile_input(list);
+    auto engine = choose_engine(profile, thresholds);
+
+    run_engine(list, engine, profile);
+    return engine;
+}
+
+
+
+//  Calibration
+//  Time the competing algorithms against each other on the host, at each
+//  decision boundary, and move the thresholds to where they cross over.
+//  Takes well under a second; the result can be kept in sort_tuning()
+
+
+// Best time in ns of 'reps' runs of 'sort' on fresh copies of 'input'
+template <typename T, typename Sort>
+double best_time(std::vector<T> const & input, int reps, Sort sort) {
+
+    double best = 1e300;
+    for (int rep = 0; rep < reps; ++rep) {
+        auto list = input;
+        auto start = std::chrono::steady_clock::now();
+        sort(list);
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    return best;
+}
+
+inline sort_thresholds calibrate_sort(std::size_t n = 1 << 17) {
+
+    sort_thresholds thresholds;
+    std::mt19937_64 rng{42};
+
+    auto random_keys = [&](std::size_t count, int range) {
+        std::vector<int> keys(count);
+        for (auto & key: keys)
+            key = rng() % range;
+        return keys;
+    };
+
+    // Insertion sort against introsort on small inputs. Many small
+    // inputs are timed together, so the clock resolution does not matter
+    for (int size = 8; size <= 256; size *= 2) {
+
+        std::vector<std::vector<int>> inputs;
+        for (int i = 0; i < 256; ++i)
+            inputs.push_back(random_keys(size, INT_MAX));
+
+        auto insertion = best_time(inputs, 5, [](std::vector<std::vector<int>> & lists) {
+            for (auto & list: lists)
+                insertion::insertion_sort(list);
+        });
+        auto general = best_time(inputs, 5, [](std::vector<std::vector<int>> & lists) {
+            for (auto & list: lists)
+                introsort(list);
+        });
+
+        if (insertion > general)
+            break;
+        thresholds.insertion_limit = size;
+    }
+
+    // Counting sort against introsort as the key range grows. Its count
+    // array grows with the range, so ranges past 16 x n are not tried
+    for (double range = 1; range <= 16; range *= 2) {
+
+        auto input = random_keys(n, int(range * n));
+        auto counting = best_time(input, 3, [](std::vector<int> & list) {
+            counting_sort_shifted(list, *std::min_element(list.begin(), list.end()));
+        });
+        auto general = best_time(input, 3, [](std::vector<int> & list) {
+            introsort(list);
+        });
+
+        if (counting > general)
+            break;
+        thresholds.counting_range = range;
+    }
+
+    // Adaptive merge sort against introsort and counting sort as presorted
+    // input gets noisier: sorted keys with a shuffled burst of 32 keys
+    // every 'spacing' keys. The ratio is the number of keys per run;
+    // lower it while the adaptive sort still wins
+    thresholds.presorted_ratio = thresholds.presorted_counting_ratio = n;
+    bool beats_counting = true;
+    for (std::size_t spacing = 4096; spacing >= 32; spacing /= 2) {
+
+        std::vector<int> input(n);
+        for (std::size_t i = 0; i < n; ++i)
+            input[i] = i;
+        for (std::size_t burst = 0; burst < n / spacing; ++burst) {
+            auto first = input.begin() + rng() % (n - 32);
+            std::shuffle(first, first + 32, rng);
+        }
+        double ratio = double(n) / profile_input(input).runs;
+
+        auto adaptive = best_time(input, 3, [](std::vector<int> & list) {
+            merging::adaptive_merge_sort(list, 0, list.size() - 1);
+        });
+        auto general = best_time(input, 3, [](std::vector<int> & list) {
+            introsort(list);
+        });
+        auto counting = best_time(input, 3, [](std::vector<int> & list) {
+            counting_sort_shifted(list, 0);
+        });
+
+        beats_counting = beats_counting && adaptive < counting;
+        if (beats_counting)
+            thresholds.presorted_counting_ratio = ratio;
+
+        if (adaptive > general)
+            break;
+        thresholds.presorted_ratio = ratio;
+    }
+
+    // Bucket sort against introsort on uniform keys in [0, 1)
+    std::vector<float> uniform(n);
+    for (auto & key: uniform)
+        key = std::uniform_real_distribution<float>(0, 1)(rng);
+
+    thresholds.bucket_uniform =
+        best_time(uniform, 3, [](std::vector<float> & list) { bucket::bucket_sort(list); }) <
+        best_time(uniform, 3, [](std::vector<float> & list) { introsort(list); });
+
+    return thresholds;
+}
+
+
+
+// Demonstration
+int main(int argc, char * argv[]) {
+
+    std::mt19937_64 rng{1};
+    const std::size_t n = 100000;
+
+    std::vector<int> small_range(n), nearly_sorted(n), wide(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        small_range[i] = rng() % 1000;
+        nearly_sorted[i] = i * 1000;
+        wide[i] = rng() % INT_MAX;
+    }
+    for (int swaps = 0; swaps < 100; ++swaps)
+        std::swap(nearly_sorted[rng() % n], nearly_sorted[rng() % n]);
+
+    std::vector<double> fractions(n);
+    for (auto & key: fractions)
+        key = std::uniform_real_distribution<double>(0, 1)(rng);
+
+    std::vector<int> few{4, 2, 9, 1, 7};
+
+    // Print which algorithm each input was given
+    std::cout << "Default thresholds...\n";
+    std::cout << "\t5 keys:                  " << engine_name(sort(few)) << '\n';
+    std::cout << "\tkeys in [0, 1000):       " << engine_name(sort(small_range)) << '\n';
+    std::cout << "\tnearly sorted keys:      " << engine_name(sort(nearly_sorted)) << '\n';
+    std::cout << "\tkeys in [0, INT_MAX):    " << engine_name(sort(wide)) << '\n';
+    std::cout << "\tuniform doubles [0, 1):  " << engine_name(sort(fractions)) << '\n';
+    std::cout << "\tsorted keys:             " << engine_name(sort(wide)) << '\n';
+
+    // Measure the thresholds on this machine, and use them from now on
+    sort_tuning() = calibrate_sort();
+
+    auto & tuned = sort_tuning();
+    std::cout << "Calibrated thresholds...\n"
+        << "\tinsertion sort up to " << tuned.insertion_limit << " keys\n"
+        << "\tcounting sort for key ranges up to " << tuned.counting_range << " x n\n"
+        << "\tadaptive merge sort for at least " << tuned.presorted_ratio << " keys per run ("
+        << tuned.presorted_counting_ratio << " in place of counting sort)\n"
+        << "\tbucket sort for uniform keys: " << (tuned.bucket_uniform ? "yes" : "no") << '\n';
+}